@@ -0,0 +1,130 @@
+// actor-grid.cpp -- The ActorGrid class, a spatial index of the Actors on a dungeon level, used to quickly find Actors near a given location.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#include "actor.h"
+#include "actor-grid.h"
+#include "guru.h"
+
+#include <algorithm>
+
+
+// Adds an Actor to the grid, at its current coordinates.
+void ActorGrid::add(Actor *actor)
+{
+	STACK_TRACE();
+	const unsigned int cx = actor->x >> ACTOR_GRID_SHIFT, cy = actor->y >> ACTOR_GRID_SHIFT;
+	if (cx >= cells_x || cy >= cells_y)
+	{
+		guru::nonfatal("Attempt to add out-of-bounds Actor to ActorGrid.", GURU_ERROR);
+		return;
+	}
+	cells.at(cx + cy * cells_x).push_back(actor);
+	total++;
+}
+
+// Returns all Actors within a given distance of a specified tile.
+vector<Actor*> ActorGrid::in_radius(unsigned short x, unsigned short y, unsigned short radius) const
+{
+	STACK_TRACE();
+	vector<Actor*> result;
+	const int radius_squared = radius * radius;
+	const int x1 = std::max(x - radius, 0), y1 = std::max(y - radius, 0);
+	for (auto actor : in_rect(x1, y1, x + radius + 1 - x1, y + radius + 1 - y1))
+	{
+		const int dx = actor->x - x, dy = actor->y - y;
+		if (dx * dx + dy * dy <= radius_squared) result.push_back(actor);
+	}
+	return result;
+}
+
+// Returns all Actors within a specified rectangle.
+vector<Actor*> ActorGrid::in_rect(unsigned short x, unsigned short y, unsigned short w, unsigned short h) const
+{
+	STACK_TRACE();
+	vector<Actor*> result;
+	if (!w || !h || !cells_x || !cells_y) return result;
+	const unsigned int x2 = x + w - 1, y2 = y + h - 1;
+	const unsigned int cx1 = x >> ACTOR_GRID_SHIFT, cy1 = y >> ACTOR_GRID_SHIFT;
+	const unsigned int cx2 = std::min<unsigned int>(x2 >> ACTOR_GRID_SHIFT, cells_x - 1), cy2 = std::min<unsigned int>(y2 >> ACTOR_GRID_SHIFT, cells_y - 1);
+	for (unsigned int cy = cy1; cy <= cy2; cy++)
+	{
+		for (unsigned int cx = cx1; cx <= cx2; cx++)
+		{
+			for (auto actor : cells[cx + cy * cells_x])
+				if (actor->x >= x && actor->x <= x2 && actor->y >= y && actor->y <= y2) result.push_back(actor);
+		}
+	}
+	return result;
+}
+
+// Returns up to the specified number of Actors closest to a specified tile, nearest first.
+// The search spreads outwards one ring of cells at a time, and stops once no unsearched cell could hold anything closer than what has already been found.
+vector<Actor*> ActorGrid::nearest(unsigned short x, unsigned short y, unsigned int count) const
+{
+	STACK_TRACE();
+	vector<std::pair<int, Actor*>> found;
+	if (!count || !cells_x || !cells_y) return vector<Actor*>();
+	const int cx = x >> ACTOR_GRID_SHIFT, cy = y >> ACTOR_GRID_SHIFT;
+	const int max_ring = std::max(std::max(cx, cells_x - 1 - cx), std::max(cy, cells_y - 1 - cy));
+	for (int ring = 0; ring <= max_ring; ring++)
+	{
+		for (int ry = cy - ring; ry <= cy + ring; ry++)
+		{
+			if (ry < 0 || ry >= cells_y) continue;
+			for (int rx = cx - ring; rx <= cx + ring; rx++)
+			{
+				if (rx < 0 || rx >= cells_x) continue;
+				if (ry != cy - ring && ry != cy + ring && rx != cx - ring && rx != cx + ring) continue;	// Only the outer edge of the ring is new.
+				for (auto actor : cells[rx + ry * cells_x])
+				{
+					const int dx = actor->x - x, dy = actor->y - y;
+					found.push_back(std::pair<int, Actor*>(dx * dx + dy * dy, actor));
+				}
+			}
+		}
+		if (found.size() < count) continue;
+
+		// Anything outside the searched area is at least this far away.
+		const int left = x - ((cx - ring) << ACTOR_GRID_SHIFT) + 1, right = ((cx + ring + 1) << ACTOR_GRID_SHIFT) - x;
+		const int top = y - ((cy - ring) << ACTOR_GRID_SHIFT) + 1, bottom = ((cy + ring + 1) << ACTOR_GRID_SHIFT) - y;
+		const int min_unsearched = std::min(std::min(left, right), std::min(top, bottom));
+		std::nth_element(found.begin(), found.begin() + count - 1, found.end(), [](const std::pair<int, Actor*> &a, const std::pair<int, Actor*> &b) { return a.first < b.first; });
+		if (found.at(count - 1).first <= min_unsearched * min_unsearched) break;
+	}
+	std::sort(found.begin(), found.end(), [](const std::pair<int, Actor*> &a, const std::pair<int, Actor*> &b) { return a.first < b.first; });
+	vector<Actor*> result;
+	for (unsigned int i = 0; i < found.size() && i < count; i++)
+		result.push_back(found.at(i).second);
+	return result;
+}
+
+// Removes an Actor from the grid; x,y are the coordinates it was added at.
+void ActorGrid::remove(Actor *actor, unsigned short x, unsigned short y)
+{
+	STACK_TRACE();
+	const unsigned int cx = x >> ACTOR_GRID_SHIFT, cy = y >> ACTOR_GRID_SHIFT;
+	if (cx < cells_x && cy < cells_y)
+	{
+		vector<Actor*> &cell = cells.at(cx + cy * cells_x);
+		auto found = std::find(cell.begin(), cell.end(), actor);
+		if (found != cell.end())
+		{
+			*found = cell.back();
+			cell.pop_back();
+			total--;
+			return;
+		}
+	}
+	guru::nonfatal("Attempt to remove unknown Actor from ActorGrid.", GURU_ERROR);
+}
+
+// Resizes the grid for a dungeon of the specified size, removing all Actors.
+void ActorGrid::resize(unsigned short width, unsigned short height)
+{
+	STACK_TRACE();
+	cells_x = (width + (1 << ACTOR_GRID_SHIFT) - 1) >> ACTOR_GRID_SHIFT;
+	cells_y = (height + (1 << ACTOR_GRID_SHIFT) - 1) >> ACTOR_GRID_SHIFT;
+	cells.clear();
+	cells.resize(cells_x * cells_y);
+	total = 0;
+}
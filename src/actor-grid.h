@@ -0,0 +1,28 @@
+// actor-grid.h -- The ActorGrid class, a spatial index of the Actors on a dungeon level, used to quickly find Actors near a given location.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#pragma once
+#include "duskfall.h"
+
+class Actor;	// defined in actor.h
+
+#define ACTOR_GRID_SHIFT	4	// Actors are bucketed into square cells, 2^ACTOR_GRID_SHIFT tiles across.
+
+
+class ActorGrid
+{
+public:
+			ActorGrid() : cells_x(0), cells_y(0), total(0) { }
+	void	add(Actor *actor);	// Adds an Actor to the grid, at its current coordinates.
+	vector<Actor*>	in_radius(unsigned short x, unsigned short y, unsigned short radius) const;	// Returns all Actors within a given distance of a specified tile.
+	vector<Actor*>	in_rect(unsigned short x, unsigned short y, unsigned short w, unsigned short h) const;	// Returns all Actors within a specified rectangle.
+	vector<Actor*>	nearest(unsigned short x, unsigned short y, unsigned int count) const;	// Returns up to the specified number of Actors closest to a specified tile, nearest first.
+	void	remove(Actor *actor, unsigned short x, unsigned short y);	// Removes an Actor from the grid; x,y are the coordinates it was added at.
+	void	resize(unsigned short width, unsigned short height);	// Resizes the grid for a dungeon of the specified size, removing all Actors.
+	unsigned int	size() const { return total; }	// The number of Actors in the grid.
+
+private:
+	unsigned short	cells_x, cells_y;	// The size of the grid, in cells.
+	vector<vector<Actor*>>	cells;	// The Actors within each cell. These pointers are non-owning; the Actors belong to the Dungeon's tiles.
+	unsigned int	total;	// The number of Actors in the grid.
+};
@@ -3,6 +3,7 @@
 
 #include "actor.h"
 #include "ai-basic.h"
+#include "atom.h"
 #include "attacker.h"
 #include "defender.h"
 #include "graveyard.h"
@@ -15,19 +16,20 @@
 #include "SQLiteCpp/SQLiteCpp.h"
 
 
-Actor::Actor(unsigned long long new_id) : ai(nullptr), flags(0), id(new_id), inventory(nullptr), x(0), y(0) { }
+Actor::Actor(unsigned long long new_id) : ai(nullptr), ai_type(ATOM_NONE), flags(0), id(new_id), inventory(nullptr), name(ATOM_NONE), shared(0), sprite(ATOM_NONE), x(0), y(0) { }
 
 Actor::~Actor() { }
 
-// Adds AI to this Actor.
-void Actor::add_ai(string type, unsigned long long new_id)
+// Adds AI to this Actor. The type is an interned atom ID.
+void Actor::add_ai(unsigned short type, unsigned long long new_id)
 {
 	STACK_TRACE();
+	static const unsigned short basic_ai = atom::intern("BASIC");
 	if (ai && ai->id != new_id) graveyard::destroy_ai(ai->id);
-	if (type == "BASIC") ai = std::make_shared<BasicAI>(this, new_id);
+	if (type == basic_ai) ai = std::make_shared<BasicAI>(this, new_id);
 	else
 	{
-		guru::nonfatal("Invalid AI type specified: " + type, GURU_ERROR);
+		guru::nonfatal("Invalid AI type specified: " + atom::name(type), GURU_ERROR);
 		return;
 	}
 	ai_type = type;
@@ -42,9 +44,9 @@ void Actor::clear_flag(unsigned int flag)
 // Gets the name of this Actor, with 'the' at the start if it doesn't have a proper noun name.
 string Actor::get_name(bool first_letter_caps) const
 {
-	if (has_proper_noun()) return name;
-	else if (first_letter_caps) return "The " + name;
-	else return "the " + name;
+	if (has_proper_noun()) return atom::name(name);
+	else if (first_letter_caps) return "The " + atom::name(name);
+	else return "the " + atom::name(name);
 }
 
 // Does this Actor have lower-priority rendering (i.e. other Actors go on top)?
@@ -112,8 +114,8 @@ void Actor::load(unsigned long long owner_id)
 		query.bind(1, static_cast<signed long long>(id));
 		if (query.executeStep())
 		{
-			name = query.getColumn("name").getString();
-			sprite = query.getColumn("sprite").getString();
+			name = atom::intern(query.getColumn("name").getString());
+			sprite = atom::intern(query.getColumn("sprite").getString());
 			flags = query.getColumn("flags").getUInt();
 			x = query.getColumn("x").getUInt();
 			y = query.getColumn("y").getUInt();
@@ -142,8 +144,7 @@ void Actor::load(unsigned long long owner_id)
 				ai_query.bind(1, static_cast<signed long long>(ai_id));
 				if (ai_query.executeStep())
 				{
-					string type = ai_query.getColumn("type").getString();
-					add_ai(type, ai_id);
+					add_ai(atom::intern(ai_query.getColumn("type").getString()), ai_id);
 					ai->load();
 				}
 				else guru::halt("Could not load AI data from save file!");
@@ -157,7 +158,22 @@ void Actor::load(unsigned long long owner_id)
 	}
 }
 
+// Gives this Actor its own copy of its Defender if it's still using its prototype's, ready to be changed.
+Defender* Actor::own_defender()
+{
+	STACK_TRACE();
+	if (shared & ACTOR_SHARED_DEFENDER)
+	{
+		defender = std::make_shared<Defender>(*defender);
+		defender->id = id;	// See save() for why the Actor's own ID is used here.
+		shared &= ~ACTOR_SHARED_DEFENDER;
+	}
+	return defender.get();
+}
+
 // Saves this Actor's data to disk.
+// Components shared with a prototype have no ID of their own, so they're saved under the Actor's ID instead. Actors and their components take their IDs from the same sequence, so this can't clash with
+// any other component, and the row stays the same when the component is copied by own_defender().
 void Actor::save(unsigned long long owner_id)
 {
 	STACK_TRACE();
@@ -169,14 +185,14 @@ void Actor::save(unsigned long long owner_id)
 		SQLite::Statement query(*world::save_db(), "INSERT INTO actors (id, owner, name, sprite, flags, x, y, inventory, attacker, defender, ai) VALUES (?,?,?,?,?,?,?,?,?,?,?)");
 		query.bind(1, static_cast<long long>(id));
 		query.bind(2, static_cast<long long>(owner_id));
-		query.bind(3, name);
-		query.bind(4, sprite);
+		query.bind(3, atom::name(name));
+		query.bind(4, atom::name(sprite));
 		query.bind(5, flags);
 		query.bind(6, x);
 		query.bind(7, y);
 		if (inventory) query.bind(8, static_cast<signed long long>(inventory->id)); else query.bind(8);
-		if (attacker) query.bind(9, static_cast<signed long long>(attacker->id)); else query.bind(9);
-		if (defender) query.bind(10, static_cast<signed long long>(defender->id)); else query.bind(10);
+		if (attacker) query.bind(9, static_cast<signed long long>((shared & ACTOR_SHARED_ATTACKER) ? id : attacker->id)); else query.bind(9);
+		if (defender) query.bind(10, static_cast<signed long long>((shared & ACTOR_SHARED_DEFENDER) ? id : defender->id)); else query.bind(10);
 		if (ai && id != 1) query.bind(11, static_cast<signed long long>(ai->id)); else query.bind(11);
 		query.exec();
 	}
@@ -186,8 +202,20 @@ void Actor::save(unsigned long long owner_id)
 	}
 
 	if (inventory) inventory->save();
-	if (attacker) attacker->save();
-	if (defender) defender->save();
+	if (attacker && (shared & ACTOR_SHARED_ATTACKER))
+	{
+		Attacker shared_attacker = *attacker;
+		shared_attacker.id = id;
+		shared_attacker.save();
+	}
+	else if (attacker) attacker->save();
+	if (defender && (shared & ACTOR_SHARED_DEFENDER))
+	{
+		Defender shared_defender = *defender;
+		shared_defender.id = id;
+		shared_defender.save();
+	}
+	else if (defender) defender->save();
 	if (ai && id != 1) ai->save();
 }
 
@@ -19,13 +19,16 @@ enum class Colour : unsigned char;	// defined in iocore.h
 #define ACTOR_FLAG_ANIMATED		(1 << 6)	// Does this Actor have an animated sprite?
 #define ACTOR_FLAG_PROPER_NOUN	(1 << 7)	// Does this Actor have a proper noun for a name (e.g. 'David', rather than 'the orc').
 
+#define ACTOR_SHARED_ATTACKER	(1 << 0)	// This Actor's Attacker belongs to the prototype it was spawned from.
+#define ACTOR_SHARED_DEFENDER	(1 << 1)	// This Actor's Defender belongs to the prototype it was spawned from.
+
 
 class Actor
 {
 public:
 					Actor(unsigned long long new_id);
 	virtual			~Actor();
-	void			add_ai(string type, unsigned long long new_id);	// Adds AI to this Actor.
+	void			add_ai(unsigned short type, unsigned long long new_id);	// Adds AI to this Actor. The type is an interned atom ID.
 	void			clear_flag(unsigned int flag);	// Clears a flag on this Actor.
 	string			get_name(bool first_letter_caps) const;	// Gets the name of this Actor, with 'the' at the start if it doesn't have a proper noun name.
 	bool			has_low_priority_rendering() const;	// Does this Actor have lower-priority rendering (i.e. other Actors go on top)?
@@ -38,18 +41,20 @@ public:
 	bool			is_los_blocker() const;	// Does this Actor block line-of-sight?
 	bool			is_monster() const;		// Is this Actor an NPC or monster?
 	virtual void	load(unsigned long long owner_id);	// Loads this Actor's data from disk.
+	Defender*		own_defender();	// Gives this Actor its own copy of its Defender if it's still using its prototype's, ready to be changed.
 	virtual void	save(unsigned long long owner_id);	// Saves this Actor's data to disk.
 	void			set_flag(unsigned int flag);	// Sets a flag on this Actor.
 	virtual void	tile_react() { }	// Reacts to other Actors on the tile this Actor is standing on.
 
 	shared_ptr<AI>	ai;			// If this Actor has AI, this is where its 'brain' is.
-	string			ai_type;	// The type of AI attached to this Actor.
+	unsigned short	ai_type;	// The type of AI attached to this Actor, as an interned atom ID.
 	shared_ptr<Attacker>	attacker;	// If this Actor is an Attacker, it attaches here.
 	shared_ptr<Defender>	defender;	// If this Actor is a Defender, it attaches here.
 	unsigned char	flags;		// The Actor's individual flags.
 	unsigned long long	id;		// The unique ID for this Actor.
 	shared_ptr<Inventory>	inventory;	// If this Actor has an Inventory, it attaches here.
-	string			name;		// The Actor's name.
-	string			sprite;		// The graphical tile used by this Actor.
+	unsigned short	name;		// The Actor's name, as an interned atom ID.
+	unsigned char	shared;		// The components (ACTOR_SHARED_*) this Actor is still using from the prototype it was spawned from. These must be copied before they are changed.
+	unsigned short	sprite;		// The graphical tile used by this Actor, as an interned atom ID.
 	unsigned short	x, y;		// X,Y coordinates on the current dungeon level.
 };
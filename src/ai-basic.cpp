@@ -14,13 +14,13 @@ void BasicAI::tick()
 {
 	STACK_TRACE();
 	if (!owner->attacker) return;	// Do nothing if we can't attack.
-	const unsigned int distance_to_player = mathx::grid_dist(owner->x, owner->y, world::hero()->x, world::hero()->y);
+	const unsigned int distance_to_player = mathx::grid_dist_int(owner->x, owner->y, world::hero()->x, world::hero()->y);
 	if (distance_to_player == 1)
 	{
 		owner->attacker->attack(owner, world::hero().get());
 		return;
 	}
-	const bool player_in_sight = world::dungeon()->los_check(owner->x, owner->y, world::hero()->x, world::hero()->y);
+	const bool player_in_sight = world::dungeon()->hero_visible(owner->x, owner->y);
 	if (player_in_sight || tracking_count)
 	{
 		if (player_in_sight) tracking_count = TRACKING_TURNS;
@@ -31,19 +31,14 @@ void BasicAI::tick()
 		if (owner->y < world::hero()->y) dy = 1;
 		else if (owner->y > world::hero()->y) dy = -1;
 		int dyo = dy;
-		Tile* target_tile = world::dungeon()->tile(owner->x + dx, owner->y + dy);
-		if (target_tile->is_impassible())
-		{
-			dy = 0;
-			target_tile = world::dungeon()->tile(owner->x + dx, owner->y);
-		}
-		if (target_tile->is_impassible())
+		shared_ptr<Dungeon> dungeon = world::dungeon();
+		if (dungeon->blocks_movement(owner->x + dx, owner->y + dy)) dy = 0;
+		if (dungeon->blocks_movement(owner->x + dx, owner->y + dy))
 		{
 			dy = dyo;
 			dx = 0;
-			target_tile = world::dungeon()->tile(owner->x, owner->y + dy);
 		}
-		if (target_tile->is_impassible()) return;
+		if (dungeon->blocks_movement(owner->x + dx, owner->y + dy)) return;
 		travel(dx, dy);
 	}
 	else state = AIState::SLEEPING;	// If tracking_count runs out, the player has been out of sight for a long time - time to go inactive.
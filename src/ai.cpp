@@ -2,6 +2,7 @@
 // Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
 
 #include "actor.h"
+#include "atom.h"
 #include "ai.h"
 #include "dungeon.h"
 #include "guru.h"
@@ -54,7 +55,7 @@ void AI::save()
 		ai_delete.exec();
 		SQLite::Statement ai_statement(*world::save_db(), "INSERT INTO ai (id, type, state, tracking_count) VALUES (?,?,?,?)");
 		ai_statement.bind(1, static_cast<signed long long>(id));
-		ai_statement.bind(2, owner->ai_type);
+		ai_statement.bind(2, atom::name(owner->ai_type));
 		ai_statement.bind(3, static_cast<unsigned int>(state));
 		ai_statement.bind(4, tracking_count);
 		ai_statement.exec();
@@ -70,32 +71,29 @@ bool AI::travel(short x_dir, short y_dir)
 {
 	STACK_TRACE();
 	shared_ptr<Dungeon> dungeon = world::dungeon();
-	Tile* target_tile = dungeon->tile(owner->x + x_dir, owner->y + y_dir);
-	if (target_tile->is_impassible()) return false;
-	for (auto actor : *target_tile->actors())
-		if (actor->is_blocker()) return false;
+	Tile target_tile = dungeon->tile(owner->x + x_dir, owner->y + y_dir);
+	if (dungeon->blocks_movement(target_tile.x, target_tile.y)) return false;
 
-	Tile* current_tile = dungeon->tile(owner->x, owner->y);
+	Tile current_tile = dungeon->tile(owner->x, owner->y);
 	const bool is_hero = (owner == world::hero().get());
 	bool removed_from_old_tile = false;
 	shared_ptr<Actor> owner_shared = nullptr;
 	if (!is_hero)
 	{
-		for (unsigned int i = 0; i < current_tile->actors()->size(); i++)
+		for (unsigned int i = 0; i < current_tile.actors().size(); i++)
 		{
-			if (current_tile->actors()->at(i).get() == owner)
+			if (current_tile.actors().at(i).get() == owner)
 			{
-				owner_shared = current_tile->actors()->at(i);
-				current_tile->actors()->erase(current_tile->actors()->begin() + i);
+				owner_shared = current_tile.remove_actor(i);
 				removed_from_old_tile = true;
-				continue;
+				break;
 			}
 		}
 		if (!removed_from_old_tile) guru::nonfatal("Could not remove " + owner->get_name(false) + " from dungeon tile!", GURU_ERROR);
 	}
 	owner->x += x_dir;
 	owner->y += y_dir;
-	if (!is_hero && removed_from_old_tile) target_tile->actors()->push_back(owner_shared);
+	if (!is_hero && removed_from_old_tile) target_tile.add_actor(owner_shared);
 	world::queue_redraw();
 	world::queue_recalc_lighting();
 	owner->tile_react();
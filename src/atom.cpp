@@ -0,0 +1,45 @@
+// atom.cpp -- The atom table, which interns frequently-used strings (such as sprite names) so they can be referred to by small integer IDs.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#include "atom.h"
+#include "guru.h"
+#include "strx.h"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+
+namespace atom
+{
+
+std::unordered_map<string, unsigned short>	atom_ids;	// Lookup table from strings to their atom IDs.
+std::mutex		atom_mutex;	// Atoms can be interned from any thread, such as when a dungeon level is generated in the background.
+std::deque<string>	atom_names = { "" };	// The interned strings, indexed by atom ID. A deque never moves its contents, so the references returned by name() stay valid.
+
+
+// Returns the atom ID for a given string, adding it to the table if it isn't already there.
+unsigned short intern(const string &str)
+{
+	STACK_TRACE();
+	if (!str.size()) return ATOM_NONE;
+	std::lock_guard<std::mutex> lock(atom_mutex);
+	auto found = atom_ids.find(str);
+	if (found != atom_ids.end()) return found->second;
+	if (atom_names.size() >= USHRT_MAX) guru::halt("Atom table is full!");
+	const unsigned short new_id = atom_names.size();
+	atom_names.push_back(str);
+	atom_ids.insert(std::pair<string, unsigned short>(str, new_id));
+	return new_id;
+}
+
+// Returns the string that a given atom ID refers to.
+const string& name(unsigned short id)
+{
+	STACK_TRACE();
+	std::lock_guard<std::mutex> lock(atom_mutex);
+	if (id >= atom_names.size()) guru::halt("Invalid atom ID: " + strx::uitos(id));
+	return atom_names.at(id);
+}
+
+}	// namespace atom
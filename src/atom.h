@@ -0,0 +1,16 @@
+// atom.h -- The atom table, which interns frequently-used strings (such as sprite names) so they can be referred to by small integer IDs.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#pragma once
+#include "duskfall.h"
+
+#define ATOM_NONE	0	// Atom ID 0 is always the empty string.
+
+
+namespace atom
+{
+
+unsigned short	intern(const string &str);	// Returns the atom ID for a given string, adding it to the table if it isn't already there.
+const string&	name(unsigned short id);	// Returns the string that a given atom ID refers to.
+
+}	// namespace atom
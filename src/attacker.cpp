@@ -39,8 +39,8 @@ void Attacker::attack(Actor *owner, Actor *target)
 	// Check if we have NPC-on-NPC aggression happening.
 	if (!hero_is_involved)
 	{
-		const bool attacker_in_sight = world::dungeon()->los_check(owner->x, owner->y);
-		const bool defender_in_sight = world::dungeon()->los_check(target->x, target->y);
+		const bool attacker_in_sight = world::dungeon()->hero_visible(owner->x, owner->y);
+		const bool defender_in_sight = world::dungeon()->hero_visible(target->x, target->y);
 		if (attacker_in_sight)
 		{
 			attack_str = owner->get_name(true) + " attacks " + (defender_in_sight ? target->get_name(false) : "something") + "!";
@@ -56,7 +56,7 @@ void Attacker::attack(Actor *owner, Actor *target)
 			else
 			{
 				// Neither attacker nor defender in sight. We'll see if we can hear this combat.
-				const unsigned int combat_range = mathx::grid_dist(world::hero()->x, world::hero()->y, owner->x, owner->y);
+				const unsigned int combat_range = mathx::grid_dist_int(world::hero()->x, world::hero()->y, owner->x, owner->y);
 				if (combat_range <= COMBAT_SOUNDS_MAX_RANGE)
 				{
 					string distance_str = "";
@@ -71,8 +71,8 @@ void Attacker::attack(Actor *owner, Actor *target)
 	{
 		// The player is attacking or being attacked!
 		bool can_see_combatant;
-		if (attacker_is_hero) can_see_combatant = world::dungeon()->los_check(target->x, target->y);
-		else can_see_combatant = world::dungeon()->los_check(owner->x, owner->y);
+		if (attacker_is_hero) can_see_combatant = world::dungeon()->hero_visible(target->x, target->y);
+		else can_see_combatant = world::dungeon()->hero_visible(owner->x, owner->y);
 		if (attacker_is_hero)
 		{
 			colour = MC::GOOD;
@@ -100,7 +100,7 @@ void Attacker::attack(Actor *owner, Actor *target)
 	}
 	else attack_str += death_str;
 	message::msg(attack_str, colour);
-	target->defender->take_damage(damage, target);
+	target->own_defender()->take_damage(damage, target);
 	if (target->defender->hp && target->ai) target->ai->react_to_attack(owner);
 }
 
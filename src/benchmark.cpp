@@ -0,0 +1,133 @@
+// benchmark.cpp -- Headless benchmarks, which can be run from the command line without starting up the game proper.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#include "benchmark.h"
+#include "dungeon.h"
+#include "guru.h"
+#include "strx.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+// The number of heap allocations made by each thread. This has to live outside the namespace, as the replacement operator new below counts them.
+static thread_local unsigned long long heap_allocations = 0;
+
+// Replacement global operator new, which counts allocations for the benchmarks. Only built when BENCHMARK_COUNT_ALLOCATIONS is defined (see compiler-options.h), so the game itself uses the standard allocator.
+void* operator new(std::size_t size)
+{
+	heap_allocations++;
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr) throw std::bad_alloc();
+	return ptr;
+}
+
+// Replacement global operator delete, to match operator new above.
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+// Sized version of operator delete, to match operator new above.
+void operator delete(void *ptr, std::size_t) noexcept
+{
+	free(ptr);
+}
+#endif	// BENCHMARK_COUNT_ALLOCATIONS
+
+
+namespace benchmark
+{
+
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+const bool				counting_allocations = true;	// Whether heap allocations are being counted in this build.
+#else
+const bool				counting_allocations = false;	// Whether heap allocations are being counted in this build.
+#endif
+const unsigned short	generation_sizes[] = { 50, 100, 200, 400 };	// The width and height of the dungeon levels generated by generation().
+
+void	report(string line);	// Prints a line of benchmark results, and writes it to the log file.
+
+
+// The number of heap allocations made by the calling thread so far, or 0 if allocations aren't being counted in this build.
+unsigned long long allocations()
+{
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+	return heap_allocations;
+#else
+	return 0;
+#endif
+}
+
+// Generates dungeon levels of various sizes, reporting how long they took and what was in them, and checks that each seed always gives the same level.
+void generation(unsigned int levels, unsigned long long first_seed)
+{
+	STACK_TRACE();
+	if (!levels) levels = 1;
+	report("Generating " + strx::uitos(levels) + " dungeon levels at each size, starting from seed " + strx::uitos(first_seed) + ".");
+#ifndef BENCHMARK_COUNT_ALLOCATIONS
+	report("Heap allocations are not counted in this build; rebuild with BENCHMARK_COUNT_ALLOCATIONS defined to count them.");
+#endif
+	unsigned int total_mismatches = 0;
+
+	for (auto size : generation_sizes)
+	{
+		double total_ms = 0;
+		unsigned long long total_allocations = 0, total_rooms = 0, total_corridors = 0, total_dead_ends = 0, combined_hash = 0;
+		unsigned int mismatches = 0;
+
+		for (unsigned int i = 0; i < levels; i++)
+		{
+			const unsigned long long seed = first_seed + i;
+			const unsigned long long allocations_before = allocations();
+			const auto start = std::chrono::steady_clock::now();
+			Dungeon level(0, size, size);
+			level.generate(seed);
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			total_ms += elapsed.count();
+			total_allocations += allocations() - allocations_before;
+
+			// Room 0 is never used, so the count starts from 1.
+			for (unsigned short r = 1; r < level.get_room_count(); r++)
+			{
+				if (level.get_room(r).corridor) total_corridors++;
+				else total_rooms++;
+			}
+			for (unsigned short x = 1; x < size - 1; x++)
+				for (unsigned short y = 1; y < size - 1; y++)
+					if (level.is_dead_end(x, y)) total_dead_ends++;
+
+			// Generate the same level again, and make sure nothing has changed.
+			const unsigned long long hash = level.layout_hash();
+			Dungeon repeat(0, size, size);
+			repeat.generate(seed);
+			if (repeat.layout_hash() != hash)
+			{
+				mismatches++;
+				report("Seed " + strx::uitos(seed) + " at " + strx::uitos(size) + "x" + strx::uitos(size) + " did not generate the same level twice!");
+			}
+			combined_hash = (combined_hash ^ hash) * 1099511628211ULL;
+		}
+
+		report(strx::uitos(size) + "x" + strx::uitos(size) + ": " + strx::ftos(total_ms / levels) + " ms per level, " + (counting_allocations ? strx::uitos(total_allocations / levels) + " allocations per level, " : "") +
+			strx::ftos(static_cast<double>(total_rooms) / levels) + " rooms, " + strx::ftos(static_cast<double>(total_corridors) / levels) + " corridors, " +
+			strx::ftos(static_cast<double>(total_dead_ends) / levels) + " dead ends, hash " + strx::uitos(combined_hash) + (mismatches ? ", " + strx::uitos(mismatches) + " MISMATCHED" : ""));
+		total_mismatches += mismatches;
+	}
+
+	if (total_mismatches) report("Dungeon generation is not deterministic!");
+	else report("Every seed generated the same level twice.");
+}
+
+// Prints a line of benchmark results, and writes it to the log file.
+void report(string line)
+{
+	STACK_TRACE();
+	std::cout << line << std::endl;
+	guru::log(line, GURU_INFO);
+}
+
+}	// namespace benchmark
@@ -0,0 +1,17 @@
+// benchmark.h -- Headless benchmarks, which can be run from the command line without starting up the game proper.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#pragma once
+#include "duskfall.h"
+
+#define BENCHMARK_DEFAULT_LEVELS	10	// The number of dungeon levels generated at each size, if not specified on the command line.
+#define BENCHMARK_DEFAULT_SEED		1	// The seed for the first dungeon level generated at each size, if not specified on the command line.
+
+
+namespace benchmark
+{
+
+unsigned long long	allocations();	// The number of heap allocations made by the calling thread so far, or 0 if allocations aren't being counted in this build.
+void	generation(unsigned int levels, unsigned long long first_seed);	// Generates dungeon levels of various sizes, reporting how long they took and what was in them, and checks that each seed always gives the same level.
+
+}	// namespace benchmark
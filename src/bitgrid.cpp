@@ -0,0 +1,55 @@
+// bitgrid.cpp -- The BitGrid class, a packed two-dimensional array of bits, used for fast per-tile lookups such as opacity and passability.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#include "bitgrid.h"
+#include "guru.h"
+
+#include <algorithm>
+
+
+// Checks if any bit is set within a rectangle. Any part of the rectangle off the edge of the grid is ignored.
+bool BitGrid::any_in_rect(unsigned short x, unsigned short y, unsigned short w, unsigned short h) const
+{
+	if (x >= width || y >= height || !w || !h) return false;
+	const unsigned int x2 = std::min<unsigned int>(x + w, width) - 1, y2 = std::min<unsigned int>(y + h, height);
+	const unsigned int first_word = x >> 6, last_word = x2 >> 6;
+	const unsigned long long first_mask = ~0ULL << (x & 63), last_mask = ~0ULL >> (63 - (x2 & 63));
+	for (unsigned int ry = y; ry < y2; ry++)
+	{
+		const unsigned long long *row_words = &words[ry * stride];
+		for (unsigned int word = first_word; word <= last_word; word++)
+		{
+			unsigned long long mask = ~0ULL;
+			if (word == first_word) mask &= first_mask;
+			if (word == last_word) mask &= last_mask;
+			if (row_words[word] & mask) return true;
+		}
+	}
+	return false;
+}
+
+// Sets or clears every bit in the grid.
+void BitGrid::fill(bool value)
+{
+	STACK_TRACE();
+	std::fill(words.begin(), words.end(), value ? ~0ULL : 0);
+}
+
+// Resizes the grid, clearing every bit.
+void BitGrid::resize(unsigned short new_width, unsigned short new_height)
+{
+	STACK_TRACE();
+	width = new_width;
+	height = new_height;
+	stride = (width + 63) / 64;
+	words.assign(stride * height, 0);
+}
+
+// Sets or clears a specified bit.
+void BitGrid::set(unsigned short x, unsigned short y, bool value)
+{
+	if (x >= width || y >= height) guru::halt("Attempted to set out-of-bounds bit in BitGrid.");
+	const unsigned long long mask = 1ULL << (x & 63);
+	if (value) words[(x >> 6) + y * stride] |= mask;
+	else words[(x >> 6) + y * stride] &= ~mask;
+}
@@ -0,0 +1,24 @@
+// bitgrid.h -- The BitGrid class, a packed two-dimensional array of bits, used for fast per-tile lookups such as opacity and passability.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#pragma once
+#include "duskfall.h"
+
+
+class BitGrid
+{
+public:
+			BitGrid() : height(0), stride(0), width(0) { }
+	bool	any_in_rect(unsigned short x, unsigned short y, unsigned short w, unsigned short h) const;	// Checks if any bit is set within a rectangle. Any part of the rectangle off the edge of the grid is ignored.
+	void	fill(bool value);	// Sets or clears every bit in the grid.
+	bool	get(unsigned short x, unsigned short y) const { return (words[(x >> 6) + y * stride] >> (x & 63)) & 1; }	// Checks a specified bit.
+	void	resize(unsigned short new_width, unsigned short new_height);	// Resizes the grid, clearing every bit.
+	void	set(unsigned short x, unsigned short y, bool value);	// Sets or clears a specified bit.
+	const unsigned long long*	row(unsigned short y) const { return &words[y * stride]; }	// Read-only access to a row of the grid, 64 tiles per word.
+
+private:
+	unsigned short	height;	// The height of the grid.
+	unsigned short	stride;	// The number of 64-bit words in each row.
+	unsigned short	width;	// The width of the grid.
+	vector<unsigned long long>	words;	// The packed bits, in rows of 64-bit words.
+};
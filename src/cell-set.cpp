@@ -0,0 +1,74 @@
+// cell-set.cpp -- The CellSet class, an unordered set of dungeon tile indices which supports constant-time insertion, removal and random selection.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#include "cell-set.h"
+#include "mathx.h"
+
+
+// Adds a cell to the set, if it isn't already there. Cells outside the set's area are ignored.
+void CellSet::add(unsigned int cell)
+{
+	const unsigned int pos = slot(cell);
+	if (pos == UINT_MAX || positions[pos] != UINT_MAX) return;
+	positions[pos] = cells.size();
+	cells.push_back(cell);
+}
+
+// Removes all cells from the set.
+void CellSet::clear()
+{
+	STACK_TRACE();
+	for (auto cell : cells)
+		positions[slot(cell)] = UINT_MAX;
+	cells.clear();
+}
+
+// Checks if a cell is in the set.
+bool CellSet::contains(unsigned int cell) const
+{
+	const unsigned int pos = slot(cell);
+	return pos != UINT_MAX && positions[pos] != UINT_MAX;
+}
+
+// Picks a random cell from the set, or UINT_MAX if the set is empty.
+unsigned int CellSet::random() const
+{
+	STACK_TRACE();
+	if (!cells.size()) return UINT_MAX;
+	return cells.at(mathx::rnd(cells.size()) - 1);
+}
+
+// Removes a cell from the set, if it's there. The last cell in the set is moved into the gap, so this doesn't need to shuffle everything along.
+void CellSet::remove(unsigned int cell)
+{
+	const unsigned int pos = slot(cell);
+	if (pos == UINT_MAX || positions[pos] == UINT_MAX) return;
+	const unsigned int index = positions[pos];
+	const unsigned int last = cells.back();
+	cells[index] = last;
+	positions[slot(last)] = index;
+	cells.pop_back();
+	positions[pos] = UINT_MAX;
+}
+
+// Sets the area of the map this set covers, and clears it.
+void CellSet::resize(unsigned short new_map_width, unsigned short new_x, unsigned short new_y, unsigned short new_w, unsigned short new_h)
+{
+	STACK_TRACE();
+	map_width = new_map_width;
+	x = new_x;
+	y = new_y;
+	w = new_w;
+	h = new_h;
+	cells.clear();
+	positions.assign(w * h, UINT_MAX);
+}
+
+// The index of a cell within the positions array, or UINT_MAX if it's outside this set's area.
+unsigned int CellSet::slot(unsigned int cell) const
+{
+	if (!map_width) return UINT_MAX;
+	const unsigned int cx = cell % map_width, cy = cell / map_width;
+	if (cx < x || cy < y || cx >= static_cast<unsigned int>(x + w) || cy >= static_cast<unsigned int>(y + h)) return UINT_MAX;
+	return (cx - x) + (cy - y) * w;
+}
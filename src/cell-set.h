@@ -0,0 +1,30 @@
+// cell-set.h -- The CellSet class, an unordered set of dungeon tile indices which supports constant-time insertion, removal and random selection.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#pragma once
+#include "duskfall.h"
+
+
+// Each CellSet covers a rectangular area of the map, set with resize(); it keeps the position of every cell in that area in a flat array, so nothing needs to be allocated or hashed as cells come and go.
+class CellSet
+{
+public:
+			CellSet() : h(0), map_width(0), w(0), x(0), y(0) { }
+	void			add(unsigned int cell);	// Adds a cell to the set, if it isn't already there. Cells outside the set's area are ignored.
+	void			clear();	// Removes all cells from the set.
+	bool			contains(unsigned int cell) const;	// Checks if a cell is in the set.
+	unsigned int	random() const;	// Picks a random cell from the set, or UINT_MAX if the set is empty.
+	void			remove(unsigned int cell);	// Removes a cell from the set, if it's there.
+	void			resize(unsigned short new_map_width, unsigned short new_x, unsigned short new_y, unsigned short new_w, unsigned short new_h);	// Sets the area of the map this set covers, and clears it.
+	unsigned int	size() const { return cells.size(); }	// The number of cells in the set.
+
+private:
+	vector<unsigned int>	cells;	// The cells in the set, in no particular order.
+	unsigned short			h;		// The height of the area this set covers.
+	unsigned short			map_width;	// The width of the map the cell indices refer to.
+	vector<unsigned int>	positions;	// The position of each cell in this set's area within the cells vector, or UINT_MAX for cells which aren't in the set.
+	unsigned short			w;		// The width of the area this set covers.
+	unsigned short			x, y;	// The top-left corner of the area this set covers.
+
+	unsigned int	slot(unsigned int cell) const;	// The index of a cell within the positions array, or UINT_MAX if it's outside this set's area.
+};
@@ -9,6 +9,10 @@
 // JsonCpp is not happy unless we define this.
 #define JSONCPP_USING_SECURE_MEMORY false
 
+// Uncomment this (or pass -DBENCHMARK_COUNT_ALLOCATIONS to the compiler) to have the -genbench benchmark count heap allocations.
+// This replaces the global operator new and delete for the whole program, so it should never be set for a build that's going to be played.
+//#define BENCHMARK_COUNT_ALLOCATIONS
+
 // Target platform.
 #if defined(_WIN32) || defined(_WIN64)
 #define TARGET_WINDOWS
@@ -1,6 +1,7 @@
 // controls.cpp -- The Controls class, which translates input from the player into game actions.
 // Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
 
+#include "atom.h"
 #include "attacker.h"
 #include "controls.h"
 #include "dungeon.h"
@@ -31,9 +32,9 @@ void Controls::close()
 		return;
 	}
 	shared_ptr<Dungeon> dungeon = world::dungeon();
-	Tile* tile = dungeon->tile(owner->x + x_dir, owner->y + y_dir);
-	shared_ptr<Actor> door = nullptr;
-	for (auto actor : *tile->actors())
+	const Tile tile = dungeon->tile(owner->x + x_dir, owner->y + y_dir);
+	Actor *door = nullptr;
+	for (auto actor : tile.actors())
 	{
 		if (actor->is_door() && !actor->is_blocker())
 		{
@@ -47,8 +48,11 @@ void Controls::close()
 		message::msg("You close the door.");
 		door->set_flag(ACTOR_FLAG_BLOCKER);
 		door->set_flag(ACTOR_FLAG_BLOCKS_LOS);
-		door->sprite = door->sprite.substr(0, door->sprite.size() - 5);
-		door->name = door->name.substr(0, door->name.size() - 9);
+		dungeon->refresh_tile(door->x, door->y);
+		const string &door_sprite = atom::name(door->sprite);
+		door->sprite = atom::intern(door_sprite.substr(0, door_sprite.size() - 5));
+		const string &door_name = atom::name(door->name);
+		door->name = atom::intern(door_name.substr(0, door_name.size() - 9));
 		world::dungeon()->recalc_lighting();
 		world::queue_redraw();
 		world::pass_time();
@@ -68,7 +72,7 @@ void Controls::drop()
 	auto inv_menu = std::make_shared<Menu>();
 	inv_menu->set_title("DROP ITEM");
 	for (auto item : owner->inventory->contents)
-		inv_menu->add_item(item->name);
+		inv_menu->add_item(atom::name(item->name));
 	int choice = inv_menu->render();
 	if (choice >= 0) drop_item(choice);
 }
@@ -81,8 +85,8 @@ void Controls::drop_item(unsigned int id)
 	owner->inventory->contents.erase(owner->inventory->contents.begin() + id);
 	item_ptr->x = owner->x;
 	item_ptr->y = owner->y;
-	world::dungeon()->tile(owner->x, owner->y)->add_actor(item_ptr);
-	message::msg("You drop the " + item_ptr->name + ".");
+	world::dungeon()->tile(owner->x, owner->y).add_actor(item_ptr);
+	message::msg("You drop the " + atom::name(item_ptr->name) + ".");
 	world::pass_time();
 }
 
@@ -98,7 +102,7 @@ void Controls::inventory()
 	auto inv_menu = std::make_shared<Menu>();
 	inv_menu->set_title("INVENTORY");
 	for (auto item : owner->inventory->contents)
-		inv_menu->add_item(item->name);
+		inv_menu->add_item(atom::name(item->name));
 	int choice = inv_menu->render();
 	if (choice >= 0) inventory_menu(choice);
 }
@@ -109,7 +113,7 @@ void Controls::inventory_menu(unsigned int id)
 	STACK_TRACE();
 	auto item = owner->inventory->contents.at(id);
 	auto inv_menu = std::make_shared<Menu>();
-	inv_menu->set_title(strx::str_toupper(item->name));
+	inv_menu->set_title(strx::str_toupper(atom::name(item->name)));
 	inv_menu->add_item("Drop");
 	int choice = inv_menu->render();
 	switch(choice)
@@ -133,25 +137,26 @@ void Controls::open()
 		return;
 	}
 	shared_ptr<Dungeon> dungeon = world::dungeon();
-	Tile* tile = dungeon->tile(owner->x + x_dir, owner->y + y_dir);
-	const unsigned int door_id = tile->has_door();
+	const Tile tile = dungeon->tile(owner->x + x_dir, owner->y + y_dir);
+	const unsigned int door_id = tile.has_door();
 	if (door_id != UINT_MAX)
 	{
-		open_door(tile->actors()->at(door_id));
+		open_door(tile.actors().at(door_id).get());
 		world::pass_time();
 	}
 	else message::msg("That isn't something you can open.", MC::WARN);
 }
 
 // Opens a specified door.
-void Controls::open_door(shared_ptr<Actor> door)
+void Controls::open_door(Actor *door)
 {
 	STACK_TRACE();
 	message::msg("You open the door.");
 	door->clear_flag(ACTOR_FLAG_BLOCKER);
 	door->clear_flag(ACTOR_FLAG_BLOCKS_LOS);
-	door->name += " (open)";
-	door->sprite += "_OPEN";
+	world::dungeon()->refresh_tile(door->x, door->y);
+	door->name = atom::intern(atom::name(door->name) + " (open)");
+	door->sprite = atom::intern(atom::name(door->sprite) + "_OPEN");
 	world::dungeon()->recalc_lighting();
 	world::queue_redraw();
 }
@@ -192,10 +197,10 @@ void Controls::take()
 		items_here.clear();
 		item_ids.clear();
 		const auto tile = world::dungeon()->tile(owner->x, owner->y);
-		const auto item_list = tile->items_here();
+		const auto item_list = tile.items_here();
 		for (unsigned int i = 0; i < item_list.size(); i++)
 		{
-			auto actor = tile->actors()->at(item_list.at(i));
+			auto actor = tile.actors().at(item_list.at(i));
 			if (actor->is_invisible()) continue;
 			items_here.push_back(actor);
 			item_ids.push_back(i);
@@ -214,7 +219,7 @@ void Controls::take()
 		{
 			shared_ptr<Menu> items_menu = std::make_shared<Menu>();
 			for (auto item : items_here)
-				items_menu->add_item(item->name);
+				items_menu->add_item(atom::name(item->name));
 			items_menu->set_title("TAKE ITEMS");
 			int choice = items_menu->render();
 			if (choice < 0) return;
@@ -228,11 +233,9 @@ void Controls::take()
 void Controls::take_item(unsigned int item)
 {
 	STACK_TRACE();
-	Tile* tile = world::dungeon()->tile(owner->x, owner->y);
-	auto item_ptr = tile->actors()->at(item);
-	tile->actors()->erase(tile->actors()->begin() + item);
+	auto item_ptr = world::dungeon()->tile(owner->x, owner->y).remove_actor(item);
 	owner->inventory->contents.push_back(item_ptr);
-	message::msg("You pick up the " + item_ptr->name + ".");
+	message::msg("You pick up the " + atom::name(item_ptr->name) + ".");
 	world::pass_time();
 }
 
@@ -253,11 +256,13 @@ bool Controls::travel(short x_dir, short y_dir)
 	{
 		shared_ptr<Dungeon> dungeon = world::dungeon();
 		const auto tile = world::dungeon()->tile(owner->x + x_dir, owner->y + y_dir);
-		for (auto actor : *tile->actors())
+		for (unsigned int i = 0; i < tile.actors().size(); i++)
 		{
+			// This has to be an owning pointer, as the attack below can kill the Actor and take it off the tile, which would otherwise destroy it while it's still being used.
+			const shared_ptr<Actor> actor = tile.actors().at(i);
 			if (actor->is_blocker())
 			{
-				if (actor->is_door()) open_door(actor);
+				if (actor->is_door()) open_door(actor.get());
 				else if (actor->defender)
 				{
 					owner->attacker->attack(world::hero().get(), actor.get());
@@ -23,6 +23,6 @@ public:
 private:
 	void	drop_item(unsigned int id);	// Drops an item on the ground.
 	void	inventory_menu(unsigned int id);	// Item menu for a specified inventory item.
-	void	open_door(shared_ptr<Actor> door);	// Opens a specified door.
+	void	open_door(Actor *door);	// Opens a specified door.
 	void	take_item(unsigned int id);	// Picks up a specific item.
 };
@@ -26,14 +26,13 @@ void Defender::die(Actor *owner)
 	}
 	else
 	{
-		Tile* owner_tile = world::dungeon()->tile(owner->x, owner->y);
+		Tile owner_tile = world::dungeon()->tile(owner->x, owner->y);
 		unsigned int tile_vector_id = UINT_MAX;
-		for (unsigned int i = 0; i < owner_tile->actors()->size(); i++)
+		for (unsigned int i = 0; i < owner_tile.actors().size(); i++)
 		{
-			const shared_ptr<Actor> actor = owner_tile->actors()->at(i);
-			if (actor.get() == owner)
+			if (owner_tile.actors().at(i).get() == owner)
 			{
-				tile_vector_id = 0;
+				tile_vector_id = i;
 				break;
 			}
 		}
@@ -42,7 +41,8 @@ void Defender::die(Actor *owner)
 			guru::nonfatal("Could not determine tile vector position for " + owner->get_name(false) + "!", GURU_CRITICAL);
 			return;
 		}
-		owner_tile->actors()->erase(owner_tile->actors()->begin() + tile_vector_id);
+		// The tile held the only owning pointer to this Actor (and so to this Defender), so it's kept alive here until we're done with it.
+		const shared_ptr<Actor> removed = owner_tile.remove_actor(tile_vector_id);
 		graveyard::destroy_actor(owner->id);
 		world::queue_redraw();
 	}
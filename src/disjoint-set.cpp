@@ -0,0 +1,39 @@
+// disjoint-set.cpp -- The DisjointSet class, a union-find structure which tracks which of a set of numbered items have been joined together.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#include "disjoint-set.h"
+#include "guru.h"
+
+#include <algorithm>
+
+
+// Creates a set of new_size items, each in a group of its own.
+DisjointSet::DisjointSet(unsigned int new_size) : parent(new_size), rank(new_size, 0)
+{
+	STACK_TRACE();
+	for (unsigned int i = 0; i < new_size; i++)
+		parent[i] = i;
+}
+
+// Returns the item representing the group that the specified item belongs to. Each item visited is pointed at its grandparent along the way, which keeps later searches short.
+unsigned int DisjointSet::find(unsigned int item)
+{
+	if (item >= parent.size()) guru::halt("Invalid item in disjoint set!");
+	while (parent[item] != item)
+	{
+		parent[item] = parent[parent[item]];
+		item = parent[item];
+	}
+	return item;
+}
+
+// Joins the groups containing two items together.
+void DisjointSet::unite(unsigned int a, unsigned int b)
+{
+	a = find(a);
+	b = find(b);
+	if (a == b) return;
+	if (rank[a] < rank[b]) std::swap(a, b);
+	parent[b] = a;
+	if (rank[a] == rank[b]) rank[a]++;
+}
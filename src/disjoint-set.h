@@ -0,0 +1,19 @@
+// disjoint-set.h -- The DisjointSet class, a union-find structure which tracks which of a set of numbered items have been joined together.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#pragma once
+#include "duskfall.h"
+
+
+class DisjointSet
+{
+public:
+			DisjointSet(unsigned int new_size);	// Creates a set of new_size items, each in a group of its own.
+	unsigned int	find(unsigned int item);	// Returns the item representing the group that the specified item belongs to.
+	bool	joined(unsigned int a, unsigned int b) { return find(a) == find(b); }	// Checks if two items are in the same group.
+	void	unite(unsigned int a, unsigned int b);	// Joins the groups containing two items together.
+
+private:
+	vector<unsigned int>	parent;	// The parent of each item; an item which is its own parent represents its group.
+	vector<unsigned int>	rank;	// An upper bound on the height of each group's tree, used to keep the trees shallow.
+};
@@ -2,13 +2,19 @@
 // Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
 
 #include "ai.h"
+#include "atom.h"
+#include "attacker.h"
+#include "defender.h"
+#include "disjoint-set.h"
 #include "dungeon.h"
 #include "guru.h"
 #include "hero.h"
+#include "inventory.h"
 #include "iocore.h"
 #include "loading.h"
 #include "mathx.h"
 #include "message.h"
+#include "ordered-pool.h"
 #include "prefs.h"
 #include "static-data.h"
 #include "strx.h"
@@ -29,20 +35,26 @@ static signed char shadowcast_multipliers[4][8] = {
 	{ 1, 0, 0, 1, -1, 0, 0, -1 }
 };
 
+FOVEngine Dungeon::fov_engine = FOVEngine::RECURSIVE;	// The field-of-view engine used for lighting.
+unsigned short Dungeon::light_cull_margin = 8;	// How many tiles beyond the edge of the screen the hero's light reaches, when culling.
+bool Dungeon::light_culling = true;	// Only calculate the hero's light for the part of the map on the screen, plus a margin around it.
+vector<unsigned char> Dungeon::light_falloff;	// The brightness of light at each squared distance from its source, up to the hero's light radius.
+RayTable Dungeon::los_rays;	// Precomputed rays used by los_batch().
 
-Dungeon::Dungeon(unsigned short new_id, unsigned short new_width, unsigned short new_height) : height(new_height), id(new_id), region(nullptr), width(new_width)
-{
-	STACK_TRACE();
-	if (!new_width || !new_height) return;
-	tiles = new Tile[width * height]();
-	lighting = new unsigned char[width * height]();
-}
 
-Dungeon::~Dungeon()
+Dungeon::Dungeon(unsigned long long new_id, unsigned short new_width, unsigned short new_height) : chunk_cols(0), dynamic_light_epoch(0), fill_flags(0), fill_proto(0), frozen(false), height(new_height), hero_fov_generation(0), id(new_id),
+	light_clip_x1(0), light_clip_y1(0), light_clip_x2(0), light_clip_y2(0), light_clipping(false), light_id_next(1), light_origin_x(USHRT_MAX), light_origin_y(USHRT_MAX), lights_changed(false), region(nullptr), width(new_width)
 {
 	STACK_TRACE();
-	delete[] tiles;
-	delete[] lighting;
+	if (!light_falloff.size())
+	{
+		// Every light source uses the same falloff curve, so the brightness at each squared distance only needs working out once.
+		light_falloff.resize(HERO_LIGHT_RADIUS * HERO_LIGHT_RADIUS);
+		for (unsigned int i = 0; i < light_falloff.size(); i++)
+			light_falloff.at(i) = diminish_light(mathx::round_to_two(sqrt(i)), LIGHT_FALLOFF);
+	}
+	if (!new_width || !new_height) return;
+	allocate_chunks();
 }
 
 // Adds an Actor's AI to the active AI list.
@@ -57,44 +69,236 @@ void Dungeon::add_active_ai(shared_ptr<AI> new_ai)
 	active_ai.push_back(new_ai);
 }
 
+// Adds a static light source, and returns its ID.
+unsigned int Dungeon::add_light(unsigned short x, unsigned short y, unsigned short radius)
+{
+	STACK_TRACE();
+	if (x >= width || y >= height) guru::halt("Attempted to add light source out of bounds!");
+	lights.push_back(LightSource(light_id_next, x, y, radius));
+	lights_changed = true;
+	return light_id_next++;
+}
+
+// Sets up the chunk index, bitboards and Actor grid, once the width and height are known. The chunks themselves are allocated as they are needed.
+void Dungeon::allocate_chunks()
+{
+	STACK_TRACE();
+	chunk_cols = (width + DUNGEON_CHUNK_SIZE - 1) >> DUNGEON_CHUNK_SHIFT;
+	const unsigned short chunk_rows = (height + DUNGEON_CHUNK_SIZE - 1) >> DUNGEON_CHUNK_SHIFT;
+	chunks.assign(chunk_cols * chunk_rows, nullptr);
+	actor_grid.resize(width, height);
+	dynamic_light_stamp.assign(chunks.size(), vector<unsigned int>());
+	light_chunks.assign(chunks.size(), vector<unsigned char>());
+	blocker_bits.resize(width, height);
+	hero_fov_bits.resize(width, height);
+	impassible_bits.resize(width, height);
+	opaque_bits.resize(width, height);
+	free_cells.resize(width, 0, 0, width, height);
+	walkable_cells.resize(width, 0, 0, width, height);
+	if (!tile_palette.size()) tile_palette.push_back(TilePrototype());	// Palette entry 0 is a blank tile, until something else is set.
+}
+
+// Gives a unique ID to anything on this level which was created without one, such as when the level was generated in the background.
+void Dungeon::assign_ids()
+{
+	STACK_TRACE();
+	vector<Actor*> actors;
+	for (auto &tile_entry : tile_actors)
+		for (auto actor : tile_entry.second)
+			actors.push_back(actor);
+
+	// Items carried in an inventory need IDs too, so they're added onto the end of the list as they're found.
+	for (unsigned int i = 0; i < actors.size(); i++)
+	{
+		Actor *actor = actors.at(i);
+		if (!actor->id) actor->id = world::unique_id();
+		if (actor->ai && !actor->ai->id) actor->ai->id = world::unique_id();
+		if (actor->attacker && !(actor->shared & ACTOR_SHARED_ATTACKER) && !actor->attacker->id) actor->attacker->id = world::unique_id();
+		if (actor->defender && !(actor->shared & ACTOR_SHARED_DEFENDER) && !actor->defender->id) actor->defender->id = world::unique_id();
+		if (actor->inventory)
+		{
+			if (!actor->inventory->id) actor->inventory->id = world::unique_id();
+			for (auto item : actor->inventory->contents)
+				actors.push_back(item.get());
+		}
+	}
+}
+
+// Assigns room IDs to the corridors, and links all the rooms and corridors together with doorways.
+void Dungeon::build_room_graph(const vector<std::pair<unsigned short, unsigned short>> &connectors)
+{
+	STACK_TRACE();
+
+	// Anything walkable that isn't part of a room is corridor. Each connected stretch of corridor gets a room ID of its own.
+	vector<unsigned int> open_cells, corridor_cells;
+	for (unsigned short y = 0; y < height; y++)
+	{
+		for (unsigned short x = 0; x < width; x++)
+		{
+			if (room_at(x, y) || impassible_bits.get(x, y)) continue;
+			if (rooms.size() >= USHRT_MAX) guru::halt("Too many rooms in dungeon!");
+			const unsigned short corridor_id = rooms.size();
+			rooms.resize(corridor_id + 1);
+			unsigned short left = x, right = x, top = y, bottom = y;
+			set_room(x, y, corridor_id);
+			open_cells.push_back(x + y * width);
+			corridor_cells.clear();
+			while (open_cells.size())
+			{
+				const unsigned short cx = open_cells.back() % width, cy = open_cells.back() / width;
+				corridor_cells.push_back(open_cells.back());
+				open_cells.pop_back();
+				if (cx < left) left = cx;
+				if (cx > right) right = cx;
+				if (cy < top) top = cy;
+				if (cy > bottom) bottom = cy;
+				for (unsigned int dir = 0; dir < 4; dir++)
+				{
+					const int nx = cx + (dir == 0) - (dir == 1), ny = cy + (dir == 2) - (dir == 3);
+					if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+					if (room_at(nx, ny) || impassible_bits.get(nx, ny)) continue;
+					set_room(nx, ny, corridor_id);
+					open_cells.push_back(nx + ny * width);
+				}
+			}
+			DungeonRoom &corridor = rooms.at(corridor_id);
+			corridor.corridor = true;
+			corridor.x = left;
+			corridor.y = top;
+			corridor.w = right - left + 1;
+			corridor.h = bottom - top + 1;
+
+			// The corridor's free cells couldn't be filled in until its bounding box was known.
+			corridor.free_cells.resize(width, corridor.x, corridor.y, corridor.w, corridor.h);
+			for (auto cell : corridor_cells)
+				refresh_tile(cell % width, cell / width);
+		}
+	}
+
+	// Rooms and corridors only meet where the generator carved an opening between them, so those are the only tiles worth checking. Each room only needs one doorway to any given neighbour,
+	// which is recorded on both sides.
+	for (auto xy : connectors)
+	{
+		const unsigned short room = room_at(xy.first, xy.second);
+		if (!room) continue;
+		for (unsigned int dir = 0; dir < 4; dir++)
+		{
+			const int nx = xy.first + (dir == 0) - (dir == 1), ny = xy.second + (dir == 2) - (dir == 3);
+			if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+			const unsigned short other = room_at(nx, ny);
+			if (!other || other == room) continue;
+			bool linked = false;
+			for (auto doorway : rooms.at(room).doorways)
+				if (doorway.target == other) { linked = true; break; }
+			if (linked) continue;
+			rooms.at(room).doorways.push_back(RoomDoorway(xy.first, xy.second, other));
+			rooms.at(other).doorways.push_back(RoomDoorway(nx, ny, room));
+		}
+	}
+}
+
+// Adds the light from every static light source onto the tiles the hero can see. Anything added is recorded in light_blend, so unblend_lights() can take it off again.
+void Dungeon::blend_lights()
+{
+	STACK_TRACE();
+	for (auto &light : lights)
+	{
+		if (light.dirty) recalc_light_map(light);
+		for (auto entry : light.light_map)
+		{
+			const unsigned short lx = entry.first % width, ly = entry.first / width;
+			const unsigned int existing = light_at(lx, ly);
+			if (!existing) continue;	// The hero can't see this tile, so it stays dark.
+			const unsigned int total = std::min(existing + entry.second, 255U);
+			if (total == existing) continue;
+			set_light(lx, ly, total);
+			light_blend.push_back(std::pair<unsigned int, unsigned char>(entry.first, total - existing));
+		}
+	}
+
+	// Walls are lit to match the brightest tile the hero can see next to them, so they don't pick up light from a source on the other side.
+	for (auto &light : lights)
+	{
+		for (auto cell : light.walls)
+		{
+			const unsigned short lx = cell % width, ly = cell / width;
+			const unsigned char existing = light_at(lx, ly);
+			if (!existing) continue;
+			unsigned char brightest = existing;
+			for (int dx = -1; dx <= 1; dx++)
+			{
+				for (int dy = -1; dy <= 1; dy++)
+				{
+					if (dx == 0 && dy == 0) continue;
+					const int nx = lx + dx, ny = ly + dy;
+					if (nx < 0 || ny < 0 || nx >= width || ny >= height || opaque_bits.get(nx, ny)) continue;
+					const unsigned char neighbour_light = light_at(nx, ny);
+					if (neighbour_light > brightest) brightest = neighbour_light;
+				}
+			}
+			if (brightest == existing) continue;
+			set_light(lx, ly, brightest);
+			light_blend.push_back(std::pair<unsigned int, unsigned char>(cell, brightest - existing));
+		}
+	}
+}
+
 // Carves out a square room.
 void Dungeon::carve_room(unsigned short x, unsigned short y, unsigned short w, unsigned short h, unsigned int new_region)
 {
 	STACK_TRACE();
 
-	Tile basic_floor = data::get_tile("BASIC_FLOOR");
+	// Anything bigger than a single corridor tile is a room, and gets its own room ID.
+	unsigned short room_id = 0;
+	if (w > 1 && h > 1)
+	{
+		if (rooms.size() >= USHRT_MAX) guru::halt("Too many rooms in dungeon!");
+		room_id = rooms.size();
+		rooms.resize(room_id + 1);
+		rooms.back().x = x;
+		rooms.back().y = y;
+		rooms.back().w = w;
+		rooms.back().h = h;
+		rooms.back().free_cells.resize(width, x, y, w, h);
+	}
+
+	static const TileID basic_floor_id = data::tile_id("BASIC_FLOOR");
+	const TilePrototype &basic_floor = data::tile(basic_floor_id);
 	for (unsigned int rx = x; rx < x + w; rx++)
 	{
 		for (unsigned int ry = y; ry < y + h; ry++)
 		{
+			if (room_id) set_room(rx, ry, room_id);
 			set_tile(rx, ry, basic_floor);
 			if (region) region[rx + ry * width] = new_region;
 		}
 	}
 
 	// Put things in this room!
-	if (w <= 1 || h <= 1) return;
+	if (!room_id) return;
+	static const MobID orc_id = data::mob_id("ORC"), platino_id = data::mob_id("PLATINO"), troll_id = data::mob_id("TROLL");
+	static const ItemID jacket_potato_id = data::item_id("JACKET_POTATO"), squiddlybox_id = data::item_id("SQUIDDLYBOX");
 	unsigned int monsters_here = mathx::rnd(4) - 1;
 	unsigned int items_here = mathx::rnd(3) - 1;
 	monsters_here = items_here = 2;
 	while (monsters_here)
 	{
 		monsters_here--;
-		string new_mob = "ORC";
-		if (mathx::rnd(10) >= 8) new_mob = "TROLL";
-		else if (mathx::rnd(10000) == 1) new_mob = "PLATINO";
-		auto success = find_empty_tile(x, y, w, h);
+		MobID new_mob = orc_id;
+		if (mathx::rnd(10) >= 8) new_mob = troll_id;
+		else if (mathx::rnd(10000) == 1) new_mob = platino_id;
+		auto success = find_empty_tile(room_id);
 		if (success.first >= width || success.second >= height) break;
-		tile(success.first, success.second)->add_actor(data::get_mob(new_mob));
+		tile(success.first, success.second).add_actor(data::get_mob(new_mob));
 	}
 	while (items_here)
 	{
 		items_here--;
-		string new_item = "JACKET_POTATO";
-		if (mathx::rnd(2) == 1) new_item = "SQUIDDLYBOX";
-		auto success = find_empty_tile(x, y, w, h);
+		ItemID new_item = jacket_potato_id;
+		if (mathx::rnd(2) == 1) new_item = squiddlybox_id;
+		auto success = find_empty_tile(room_id);
 		if (success.first >= width || success.second >= height) break;
-		tile(success.first, success.second)->add_actor(data::get_item(new_item));
+		tile(success.first, success.second).add_actor(data::get_item(new_item));
 	}
 }
 
@@ -102,9 +306,15 @@ void Dungeon::carve_room(unsigned short x, unsigned short y, unsigned short w, u
 void Dungeon::cast_light(unsigned int x, unsigned int y, unsigned int radius, unsigned int row, float start_slope, float end_slope, unsigned int xx, unsigned int xy, unsigned int yx, unsigned int yy, bool always_visible)
 {
 	STACK_TRACE();
+	if (fov_engine == FOVEngine::SYMMETRIC)
+	{
+		cast_light_symmetric(x, y, radius, row, 0, 1, 1, 1, xx, xy, yx, yy, always_visible);
+		return;
+	}
 	if (start_slope < end_slope) return;
 	float next_start_slope = start_slope;
-	for (unsigned int i = row; i <= radius; i++)
+	const unsigned int max_depth = (light_clipping ? std::min(radius, light_clip_depth(x, y, xy, yy)) : radius);
+	for (unsigned int i = row; i <= max_depth; i++)
 	{
 		bool blocked = false;
 		for (int dx = -i, dy = -i; dx <= 0; dx++)
@@ -122,20 +332,15 @@ void Dungeon::cast_light(unsigned int x, unsigned int y, unsigned int radius, un
 			if (ax >= width || ay >= height) continue;
 
 			unsigned int radius2 = radius * radius;
-			if (static_cast<unsigned int>(dx * dx + dy * dy) < radius2)
+			const bool clipped = light_clipping && (ax < light_clip_x1 || ax > light_clip_x2 || ay < light_clip_y1 || ay > light_clip_y2);
+			if (!clipped && static_cast<unsigned int>(dx * dx + dy * dy) < radius2)
 			{
-				const unsigned char existing_light = lighting[ax + ay * width];
-				if (always_visible || existing_light)
-				{
-					std::pair<unsigned short, unsigned short> xy = { ax, ay };
-					if (dynamic_light_temp.find(xy) == dynamic_light_temp.end()) dynamic_light_temp.insert(xy);
-				}
+				if ((always_visible || light_at(ax, ay)) && stamp_light(ax, ay)) dynamic_light_temp.push_back(ax + ay * width);
 			}
 
-			Tile* the_tile = tile(ax, ay);
 			if (blocked)
 			{
-				if (the_tile->is_opaque() || the_tile->contains_los_blocker())
+				if (opaque_bits.get(ax, ay))
 				{
 					next_start_slope = r_slope;
 					continue;
@@ -146,7 +351,7 @@ void Dungeon::cast_light(unsigned int x, unsigned int y, unsigned int radius, un
 					start_slope = next_start_slope;
 				}
 			}
-			else if (the_tile->is_opaque() || the_tile->contains_los_blocker())
+			else if (opaque_bits.get(ax, ay))
 			{
 				blocked = true;
 				next_start_slope = r_slope;
@@ -157,34 +362,163 @@ void Dungeon::cast_light(unsigned int x, unsigned int y, unsigned int radius, un
 	}
 }
 
+// Symmetric shadowcasting engine, based on Albert Ford's symmetric shadowcasting algorithm. This works on the same octants as cast_light(), but slopes are kept as integer fractions (numerator and
+// denominator), and a floor tile is only visible if the line from its centre to the origin is unobstructed, so if A can see B then B can also see A.
+void Dungeon::cast_light_symmetric(unsigned int x, unsigned int y, unsigned int radius, unsigned int row, unsigned int start_num, unsigned int start_den, unsigned int end_num, unsigned int end_den, int xx, int xy,
+	int yx, int yy, bool always_visible)
+{
+	STACK_TRACE();
+	const unsigned int radius2 = radius * radius;
+	const unsigned int max_depth = (light_clipping ? std::min(radius, light_clip_depth(x, y, xy, yy)) : radius);
+	for (unsigned int depth = row; depth <= max_depth; depth++)
+	{
+		// The columns are the tiles whose centres fall within the slopes, rounding ties outwards.
+		const unsigned int min_col = (2 * depth * start_num + start_den) / (2 * start_den);
+		const int max_col_twice = static_cast<int>(2 * depth * end_num) - static_cast<int>(end_den);
+		const unsigned int max_col = (max_col_twice <= 0 ? 0 : (max_col_twice + 2 * end_den - 1) / (2 * end_den));
+		if (min_col > max_col) return;
+
+		bool prev_wall = false;
+		for (unsigned int col = min_col; col <= max_col; col++)
+		{
+			const int ax = static_cast<int>(x) - static_cast<int>(col) * xx - static_cast<int>(depth) * xy;
+			const int ay = static_cast<int>(y) - static_cast<int>(col) * yx - static_cast<int>(depth) * yy;
+			const bool in_bounds = (ax >= 0 && ay >= 0 && ax < width && ay < height);
+			const bool wall = (!in_bounds || opaque_bits.get(ax, ay));
+			const bool symmetric = (col * start_den >= depth * start_num && col * end_den <= depth * end_num);
+			const bool clipped = light_clipping && (ax < light_clip_x1 || ax > light_clip_x2 || ay < light_clip_y1 || ay > light_clip_y2);
+			if (in_bounds && !clipped && col * col + depth * depth < radius2 && (wall || symmetric))
+			{
+				if ((always_visible || light_at(ax, ay)) && stamp_light(ax, ay)) dynamic_light_temp.push_back(ax + ay * width);
+			}
+			if (col > min_col)
+			{
+				if (prev_wall && !wall)
+				{
+					start_num = 2 * col - 1;
+					start_den = 2 * depth;
+				}
+				else if (!prev_wall && wall) cast_light_symmetric(x, y, radius, depth + 1, start_num, start_den, 2 * col - 1, 2 * depth, xx, xy, yx, yy, always_visible);
+			}
+			prev_wall = wall;
+		}
+		if (prev_wall) return;
+	}
+}
+
+// Returns the chunk containing a specified tile, or nullptr if it has not been allocated.
+TileChunk* Dungeon::chunk(unsigned short x, unsigned short y) const
+{
+	return chunks[chunk_index(x, y)].get();
+}
+
 // Dims a specified light source.
-unsigned char Dungeon::diminish_light(float distance, float falloff) const
+unsigned char Dungeon::diminish_light(float distance, float falloff)
 {
 	STACK_TRACE();
 	float divisor = pow(distance, falloff) - distance + 1;
 	return static_cast<unsigned char>(round(255.0f / divisor));
 }
 
+// Dims a light source at a given squared distance, using the falloff lookup table.
+unsigned char Dungeon::diminish_light_sq(unsigned int dist_sq)
+{
+	if (dist_sq < light_falloff.size()) return light_falloff[dist_sq];
+	return diminish_light(mathx::round_to_two(sqrt(dist_sq)), LIGHT_FALLOFF);
+}
+
 // Marks a given tile as explored.
 void Dungeon::explore(unsigned short x, unsigned short y)
 {
 	STACK_TRACE();
-	tiles[x + y * width].flags |= TILE_FLAG_EXPLORED;
+	TileChunk *the_chunk = touch_chunk(x, y);
+	unsigned char &flags = the_chunk->flags[local_index(x, y)];
+	if (flags & TILE_FLAG_EXPLORED) return;
+	flags |= TILE_FLAG_EXPLORED;
+	the_chunk->dirty = true;
 }
 
-// Attempts to find an empty tile within the specified space, aborts after too many failures.
-std::pair<unsigned short, unsigned short> Dungeon::find_empty_tile(unsigned short x, unsigned short y, unsigned short w, unsigned short h) const
+// Resets every tile in the dungeon to the same type, without allocating any chunks. This is intended for new levels, before they are generated.
+void Dungeon::fill(const TilePrototype &new_tile)
 {
 	STACK_TRACE();
-	unsigned int attempts = 0;
-	while (attempts++ < 100)
+	fill_proto = palette_id(new_tile);
+	fill_flags = new_tile.flags;
+	std::fill(chunks.begin(), chunks.end(), nullptr);
+	light_chunks.assign(chunks.size(), vector<unsigned char>());
+	impassible_bits.fill(fill_flags & TILE_FLAG_IMPASSIBLE);
+	opaque_bits.fill(fill_flags & TILE_FLAG_OPAQUE);
+	walkable_cells.clear();
+	free_cells.clear();
+	rooms.clear();
+	rooms.resize(1);	// Room ID 0 means the tile isn't part of any room.
+	hero_fov_bits.fill(false);
+	light_blend.clear();
+	light_dirty.clear();
+	light_origin_x = light_origin_y = USHRT_MAX;
+	if (!(fill_flags & TILE_FLAG_IMPASSIBLE))
 	{
-		unsigned int tx = mathx::rnd(w) - 1 + x;
-		unsigned int ty = mathx::rnd(h) - 1 + y;
-		if (tile(tx, ty)->is_impassible() || tile(tx, ty)->actors()->size()) continue;
-		return std::pair<unsigned short, unsigned short>(tx, ty);
+		// This is the slow path, but filling a whole level with a walkable tile is unusual.
+		for (unsigned int i = 0; i < static_cast<unsigned int>(width * height); i++)
+		{
+			walkable_cells.add(i);
+			free_cells.add(i);
+		}
 	}
-	return std::pair<unsigned short, unsigned short>(USHRT_MAX, USHRT_MAX);
+	for (const auto &actors : tile_actors)
+		refresh_tile(actors.first % width, actors.first / width);
+}
+
+// Picks a random empty tile within the specified room, or returns USHRT_MAX coordinates if the room is full.
+std::pair<unsigned short, unsigned short> Dungeon::find_empty_tile(unsigned short room) const
+{
+	STACK_TRACE();
+	if (room >= rooms.size()) return std::pair<unsigned short, unsigned short>(USHRT_MAX, USHRT_MAX);
+	const unsigned int cell = rooms.at(room).free_cells.random();
+	if (cell == UINT_MAX) return std::pair<unsigned short, unsigned short>(USHRT_MAX, USHRT_MAX);
+	return std::pair<unsigned short, unsigned short>(cell % width, cell / width);
+}
+
+// Returns the flags of a specified tile.
+unsigned char Dungeon::flags_at(unsigned short x, unsigned short y) const
+{
+	const TileChunk *the_chunk = chunk(x, y);
+	if (the_chunk) return the_chunk->flags[local_index(x, y)];
+	return fill_flags;
+}
+
+// Drops the lighting, bitboards and free cell indexes, which can all be worked out again later, while this level isn't the current one.
+// Nothing on a frozen level can be looked at or changed until thaw() is called, except for saving it.
+void Dungeon::freeze()
+{
+	STACK_TRACE();
+	if (frozen) return;
+	frozen = true;
+
+	vector<vector<unsigned char>>().swap(light_chunks);
+	for (unsigned int i = 0; i < 8; i++)
+		vector<unsigned int>().swap(hero_light_cells[i]);
+	for (auto &light : lights)
+	{
+		vector<std::pair<unsigned int, unsigned char>>().swap(light.light_map);
+		vector<unsigned int>().swap(light.walls);
+		light.dirty = true;
+	}
+	vector<vector<unsigned int>>().swap(dynamic_light_stamp);
+	vector<unsigned int>().swap(dynamic_light_temp);
+	vector<std::pair<unsigned int, unsigned char>>().swap(light_blend);
+	vector<unsigned int>().swap(light_dirty);
+	light_clipping = false;
+	light_origin_x = light_origin_y = USHRT_MAX;
+
+	blocker_bits = BitGrid();
+	hero_fov_bits = BitGrid();
+	impassible_bits = BitGrid();
+	opaque_bits = BitGrid();
+	free_cells = CellSet();
+	walkable_cells = CellSet();
+	for (auto &room : rooms)
+		room.free_cells = CellSet();
 }
 
 // Generates a new dungeon level.
@@ -192,31 +526,36 @@ void Dungeon::generate()
 {
 	STACK_TRACE();
 
-	// Set a default layout with basic floor tiles and an impassible wall.
-	Tile indestructible_wall = data::get_tile("BOUNDARY_WALL");
-	Tile regular_wall = data::get_tile("BASIC_WALL");
+	// Set a default layout of basic walls, surrounded by an impassible wall.
+	static const TileID indestructible_wall_id = data::tile_id("BOUNDARY_WALL"), regular_wall_id = data::tile_id("BASIC_WALL");
+	const TilePrototype &indestructible_wall = data::tile(indestructible_wall_id);
+	const TilePrototype &regular_wall = data::tile(regular_wall_id);
 
-	for (unsigned short y = 0; y < height; y++)
+	fill(regular_wall);
+	for (unsigned short x = 0; x < width; x++)
 	{
-		if (y == 0 || y == height - 1)
-		{
-			for (unsigned short x = 0; x < width; x++)
-				set_tile(x, y, indestructible_wall);
-		}
-		else
-		{
-			for (unsigned short x = 0; x < width; x++)
-			{
-				if (x == 0 || x == width - 1) set_tile(x, y, indestructible_wall);
-				else set_tile(x, y, regular_wall);
-			}
-		}
+		set_tile(x, 0, indestructible_wall);
+		set_tile(x, height - 1, indestructible_wall);
+	}
+	for (unsigned short y = 1; y < height - 1; y++)
+	{
+		set_tile(0, y, indestructible_wall);
+		set_tile(width - 1, y, indestructible_wall);
 	}
 
 	// For now, there is only one type of dungeon level generator.
 	generate_type_a();
 }
 
+// Generates a new dungeon level from a specified seed. The same seed and level size will always give the same layout.
+// This reseeds the calling thread's pseudorandom number generator, so it should only be used on a thread of its own, or when the game isn't running.
+void Dungeon::generate(unsigned long long seed)
+{
+	STACK_TRACE();
+	mathx::seed_thread(seed);
+	generate();
+}
+
 // Generates a type A dungeon level. This is based roughly on the procedural dungeon generator by Bob Nystrom in Hauberk, (c) 2000-2014.
 void Dungeon::generate_type_a()
 {
@@ -225,15 +564,25 @@ void Dungeon::generate_type_a()
 	unsigned int current_region = 1;
 
 	// First, place a number of randomly-sized rooms in random positions. Any rooms which overlap other rooms are removed.
-	const unsigned int attempts = (width * height) / 25;	// a 100x100 dungeon would have 400 attempts. I have not tested if this scales well for very large dungeons, so be careful.
+	const unsigned int attempts = (width * height) / 25;	// a 100x100 dungeon would have 400 attempts.
+
+	// Anything that isn't a destroyable wall gets in the way of a new room. Keeping these in a bitboard means each attempt only needs to test a few words per row, rather than every tile.
+	BitGrid room_blockers;
+	room_blockers.resize(width, height);
+	for (unsigned short x = 0; x < width; x++)
+		for (unsigned short y = 0; y < height; y++)
+			if (!tile(x, y).is_destroyable_wall()) room_blockers.set(x, y, true);
 
 	for (unsigned int i = 0; i < attempts; i++)
 	{
 		const unsigned int room_width = (mathx::rnd(3) * 2) + 3, room_height = (mathx::rnd(3) * 2) + 3;	// Room size varies from 5x5 to 9x9.
 		const unsigned int room_x = (mathx::rnd((width - room_width) / 2) * 2);
 		const unsigned int room_y = (mathx::rnd((height - room_height) / 2) * 2);
-		if (!viable_room_position(room_x, room_y, room_width, room_height)) continue;	// Abort if it overlaps anything  else.
+		if (room_blockers.any_in_rect(room_x - 1, room_y - 1, room_width + 3, room_height + 3)) continue;	// Abort if it overlaps anything  else.
 		carve_room(room_x, room_y, room_width, room_height, current_region++);	// We're good to go, place the room!
+		for (unsigned short x = room_x; x < room_x + room_width; x++)
+			for (unsigned short y = room_y; y < room_y + room_height; y++)
+				room_blockers.set(x, y, true);
 	}
 
 	// Now fill the remaining solid areas in with mazes. I'm adapting the Growing Tree algorithm from here: http://www.astrolog.org/labyrnth/algrithm.htm
@@ -243,12 +592,12 @@ void Dungeon::generate_type_a()
 		for (unsigned short y = 2; y < height - 2; y += 2)
 			if (viable_maze_position(x, y)) viable_maze_cells.push_back(std::pair<unsigned short, unsigned short>(x, y));
 
-	while (viable_maze_cells.size())
+	OrderedPool maze_pool(viable_maze_cells.size());	// The cells are picked at random, but the pool keeps the rest in order, just as if they'd been erased from the vector.
+	while (maze_pool.size())
 	{
-		unsigned int choice = mathx::rnd(viable_maze_cells.size() - 1);
+		const unsigned int choice = maze_pool.take(mathx::rnd(maze_pool.size() - 1));
 		unsigned short x = viable_maze_cells.at(choice).first;
 		unsigned short y = viable_maze_cells.at(choice).second;
-		viable_maze_cells.erase(viable_maze_cells.begin() + choice);
 		if (!viable_maze_position(x, y)) continue;
 		current_region++;
 		while(true)
@@ -270,23 +619,27 @@ void Dungeon::generate_type_a()
 		}
 	}
 
-	// Link all the regions together.
-	vector<std::pair<unsigned short, unsigned short>> region_connectors;
+	// Link all the regions together. Rather than re-flooding a region with a new ID every time it's linked to another, the regions joined so far are tracked as groups in a disjoint set.
+	// Every opening carved from here on is remembered, as these are the only places where a room can meet a corridor.
+	DisjointSet region_groups(current_region + 1);
+	vector<std::pair<unsigned short, unsigned short>> region_connectors, carved_connectors;
 	for (unsigned short x = 2; x < width - 2; x++)
 		for (unsigned short y = 2; y < width - 2; y++)
 			if (touches_two_regions(x, y)) region_connectors.push_back(std::pair<unsigned short, unsigned short>(x, y));
-	while(region_connectors.size())
+	OrderedPool connector_pool(region_connectors.size());
+	while(connector_pool.size())
 	{
-		unsigned int choice = mathx::rnd(region_connectors.size()) - 1;
+		unsigned int choice = connector_pool.take(mathx::rnd(connector_pool.size()) - 1);
 		std::pair<unsigned short, unsigned short> xy = region_connectors.at(choice);
-		region_connectors.erase(region_connectors.begin() + choice);
 
 		vector<std::pair<signed char, signed char>> viable_directions;
-		unsigned int current_region = region[xy.first + xy.second * width];
-		if (region[(xy.first + 2) + xy.second * width] != current_region && region[(xy.first + 2) + xy.second * width] != 0) viable_directions.push_back(std::pair<signed char, signed char>(1, 0));
-		if (region[(xy.first - 2) + xy.second * width] != current_region && region[(xy.first - 2) + xy.second * width] != 0) viable_directions.push_back(std::pair<signed char, signed char>(-1, 0));
-		if (region[xy.first + (xy.second + 2) * width] != current_region && region[xy.first + (xy.second + 2) * width] != 0) viable_directions.push_back(std::pair<signed char, signed char>(0, 1));
-		if (region[xy.first + (xy.second - 2) * width] != current_region && region[xy.first + (xy.second - 2) * width] != 0) viable_directions.push_back(std::pair<signed char, signed char>(0, -1));
+		const unsigned int current_region = region[xy.first + xy.second * width];
+		const unsigned int region_e = region[(xy.first + 2) + xy.second * width], region_w = region[(xy.first - 2) + xy.second * width];
+		const unsigned int region_s = region[xy.first + (xy.second + 2) * width], region_n = region[xy.first + (xy.second - 2) * width];
+		if (region_e && !region_groups.joined(region_e, current_region)) viable_directions.push_back(std::pair<signed char, signed char>(1, 0));
+		if (region_w && !region_groups.joined(region_w, current_region)) viable_directions.push_back(std::pair<signed char, signed char>(-1, 0));
+		if (region_s && !region_groups.joined(region_s, current_region)) viable_directions.push_back(std::pair<signed char, signed char>(0, 1));
+		if (region_n && !region_groups.joined(region_n, current_region)) viable_directions.push_back(std::pair<signed char, signed char>(0, -1));
 		if (!viable_directions.size()) continue;
 
 		while (viable_directions.size())
@@ -294,9 +647,14 @@ void Dungeon::generate_type_a()
 			choice = mathx::rnd(viable_directions.size()) - 1;
 			std::pair<signed char, signed char> dir = viable_directions.at(choice);
 			viable_directions.erase(viable_directions.begin() + choice);
-			unsigned int target_region = region[(xy.first + (dir.first * 2)) + (xy.second + (dir.second * 2)) * width];
-			carve_room(xy.first + dir.first, xy.second + dir.second, 1, 1, target_region);
-			region_floodfill(xy.first + dir.first, xy.second + dir.second, current_region);
+			const unsigned short cx = xy.first + dir.first, cy = xy.second + dir.second;
+			carve_room(cx, cy, 1, 1, current_region);
+			carved_connectors.push_back(std::pair<unsigned short, unsigned short>(cx, cy));
+
+			// The new opening joins together every region it touches, not just the two it was made for.
+			const unsigned int neighbours[4] = { region[(cx + 1) + cy * width], region[(cx - 1) + cy * width], region[cx + (cy + 1) * width], region[cx + (cy - 1) * width] };
+			for (unsigned int i = 0; i < 4; i++)
+				if (neighbours[i]) region_groups.unite(neighbours[i], current_region);
 			if (mathx::rnd(3) != 1) break;
 		}
 	}
@@ -306,22 +664,24 @@ void Dungeon::generate_type_a()
 	for (unsigned short x = 2; x < width - 2; x++)
 		for (unsigned short y = 2; y < height - 2; y++)
 			if (is_dead_end(x, y)) dead_ends.push_back(std::pair<unsigned short, unsigned short>(x, y));
-	while (dead_ends.size())
+	for (auto xy : dead_ends)
 	{
-		std::pair<unsigned short, unsigned short> xy = dead_ends.at(0);
-		dead_ends.erase(dead_ends.begin());
 		if (!is_dead_end(xy.first, xy.second) || mathx::rnd(3) != 1) continue;
 		vector<std::pair<signed char, signed char>> viable_directions;
-		if (tile(xy.first + 1, xy.second)->is_destroyable_wall()) viable_directions.push_back(std::pair<signed char, signed char>(1, 0));
-		if (tile(xy.first - 1, xy.second)->is_destroyable_wall()) viable_directions.push_back(std::pair<signed char, signed char>(-1, 0));
-		if (tile(xy.first, xy.second + 1)->is_destroyable_wall()) viable_directions.push_back(std::pair<signed char, signed char>(0, 1));
-		if (tile(xy.first, xy.second - 1)->is_destroyable_wall()) viable_directions.push_back(std::pair<signed char, signed char>(0, -1));
+		if (tile(xy.first + 1, xy.second).is_destroyable_wall()) viable_directions.push_back(std::pair<signed char, signed char>(1, 0));
+		if (tile(xy.first - 1, xy.second).is_destroyable_wall()) viable_directions.push_back(std::pair<signed char, signed char>(-1, 0));
+		if (tile(xy.first, xy.second + 1).is_destroyable_wall()) viable_directions.push_back(std::pair<signed char, signed char>(0, 1));
+		if (tile(xy.first, xy.second - 1).is_destroyable_wall()) viable_directions.push_back(std::pair<signed char, signed char>(0, -1));
 		if (!viable_directions.size()) continue;
 		unsigned int choice = mathx::rnd(viable_directions.size()) - 1;
-		carve_room(xy.first + viable_directions.at(choice).first, xy.second + viable_directions.at(choice).second, 1, 1, 0);
+		const unsigned short cx = xy.first + viable_directions.at(choice).first, cy = xy.second + viable_directions.at(choice).second;
+		carve_room(cx, cy, 1, 1, 0);
+		carved_connectors.push_back(std::pair<unsigned short, unsigned short>(cx, cy));
 	}
 
 	// Attempt to place doors in room entrances.
+	static const TileFeatureID door_id = data::tile_feature_id("DOOR");
+	static const unsigned short door_horiz_sprite = atom::intern(atom::name(data::tile_feature(door_id).sprite) + "_HORIZ");
 	for (unsigned short x = 2; x < width - 2; x++)
 	{
 		for (unsigned short y = 2; y < height - 2; y++)
@@ -329,14 +689,44 @@ void Dungeon::generate_type_a()
 			const int door_type = viable_doorway(x, y);
 			if (door_type && mathx::rnd(3) == 1)
 			{
-				shared_ptr<Actor> door = data::get_tile_feature("DOOR");
-				tile(x, y)->add_actor(door);
-				if (door_type == 2) door->sprite += "_HORIZ";
+				shared_ptr<Actor> door = data::get_tile_feature(door_id);
+				if (door_type == 2) door->sprite = door_horiz_sprite;
+				tile(x, y).add_actor(door);
 			}
 		}
 	}
 
 	delete[] region;
+	region = nullptr;
+	build_room_graph(carved_connectors);
+}
+
+// Read-only access to a specified static light source.
+const LightSource& Dungeon::get_light(unsigned int light_id) const
+{
+	STACK_TRACE();
+	for (const auto &light : lights)
+		if (light.id == light_id) return light;
+	guru::halt("Invalid light source ID: " + strx::uitos(light_id));
+	return lights.at(0);
+}
+
+// Read-only access to a specified room.
+const DungeonRoom& Dungeon::get_room(unsigned short room) const
+{
+	STACK_TRACE();
+	if (room >= rooms.size()) guru::halt("Invalid room ID: " + strx::uitos(room));
+	return rooms.at(room);
+}
+
+// Checks if a tile is within the hero's field of view. This is the same field of view used for lighting, so it's a single lookup rather than a line-of-sight walk. This never recalculates the
+// lighting itself (that's left to the render and turn code); if the hero has moved or something has changed opacity since the lighting was last calculated, it falls back on los_check() instead.
+bool Dungeon::hero_visible(unsigned short x, unsigned short y) const
+{
+	if (x >= width || y >= height) return false;
+	if (world::hero()->x != light_origin_x || world::hero()->y != light_origin_y || light_dirty.size()) return los_check(x, y);	// The lighting is out of date, so we can't trust it.
+	if (light_clipping && (x < light_clip_x1 || x > light_clip_x2 || y < light_clip_y1 || y > light_clip_y2)) return los_check(x, y);	// Off the edge of the lighting area, so we have to check the hard way.
+	return hero_fov_bits.get(x, y);
 }
 
 // Check to see if this tile is a dead-end.
@@ -344,56 +734,187 @@ bool Dungeon::is_dead_end(unsigned short x, unsigned short y) const
 {
 	STACK_TRACE();
 	unsigned int surrounding_walls = 0;
-	if (tile(x, y)->is_wall()) return false;
-	if (tile(x + 1, y)->is_wall()) surrounding_walls++;
-	if (tile(x - 1, y)->is_wall()) surrounding_walls++;
-	if (tile(x, y + 1)->is_wall()) surrounding_walls++;
-	if (tile(x, y - 1)->is_wall()) surrounding_walls++;
+	if (tile(x, y).is_wall()) return false;
+	if (tile(x + 1, y).is_wall()) surrounding_walls++;
+	if (tile(x - 1, y).is_wall()) surrounding_walls++;
+	if (tile(x, y + 1).is_wall()) surrounding_walls++;
+	if (tile(x, y - 1).is_wall()) surrounding_walls++;
 	if (surrounding_walls == 3) return true;
 	else return false;
 }
 
+// Hashes the tiles and Actors of this level, so two levels can be checked for being identical. Tile types and sprites are hashed by name rather than ID, so the result doesn't depend on the order
+// they were added to the palette or interned in.
+unsigned long long Dungeon::layout_hash() const
+{
+	STACK_TRACE();
+	unsigned long long result = 14695981039346656037ULL;
+	auto mix = [&result](unsigned long long value) { result = (result ^ value) * 1099511628211ULL; };
+
+	vector<unsigned int> palette_hashes(tile_palette.size());
+	for (unsigned int i = 0; i < tile_palette.size(); i++)
+		palette_hashes.at(i) = strx::hash(tile_palette.at(i).name);
+
+	mix(width);
+	mix(height);
+	for (unsigned short y = 0; y < height; y++)
+	{
+		for (unsigned short x = 0; x < width; x++)
+		{
+			mix(palette_hashes[proto_at(x, y)]);
+			mix(flags_at(x, y));
+			for (auto actor : tile(x, y).actors())
+				mix(strx::hash(atom::name(actor->sprite)));
+		}
+	}
+	return result;
+}
+
+// Returns the light level of a specified tile.
+unsigned char Dungeon::light_at(unsigned short x, unsigned short y) const
+{
+	const vector<unsigned char> &light_chunk = light_chunks[chunk_index(x, y)];
+	if (light_chunk.size()) return light_chunk[local_index(x, y)];
+	return 0;
+}
+
+// Returns how far a shadowcasting octant can go before leaving the lighting clip area. The octant's rows run along the direction given by its xy and yy multipliers.
+unsigned int Dungeon::light_clip_depth(unsigned int x, unsigned int y, int xy, int yy) const
+{
+	int depth = 0;
+	if (xy < 0) depth = light_clip_x2 - static_cast<int>(x);
+	else if (xy > 0) depth = static_cast<int>(x) - light_clip_x1;
+	else if (yy < 0) depth = light_clip_y2 - static_cast<int>(y);
+	else depth = static_cast<int>(y) - light_clip_y1;
+	return (depth > 0 ? depth : 0);
+}
+
 // Loads this dungeon from disk.
 void Dungeon::load()
 {
 	STACK_TRACE();
 	try
 	{
-		SQLite::Statement query(*world::save_db(), "SELECT width, height FROM dungeon WHERE id = ?");
+		unsigned short fill_id = 0;
+		SQLite::Statement query(*world::save_db(), "SELECT width, height, fill FROM dungeon WHERE id = ?");
 		query.bind(1, static_cast<signed long long>(id));
 		if (query.executeStep())
 		{
 			width = query.getColumn("width").getUInt();
 			height = query.getColumn("height").getUInt();
-			tiles = new Tile[width * height]();
-			lighting = new unsigned char[width * height]();
+			fill_id = query.getColumn("fill").getUInt();
+			allocate_chunks();
 		}
 		else guru::halt("Could not load data for dungeon ID " + strx::uitos(id));
 
+		// The palette has to be restored exactly as it was saved, as the chunks refer to it by index.
+		tile_palette.clear();
+		tile_palette_lookup.clear();
+		SQLite::Statement palette_query(*world::save_db(), "SELECT * FROM palette WHERE dungeon_id = ? ORDER BY id ASC");
+		palette_query.bind(1, static_cast<signed long long>(id));
+		while (palette_query.executeStep())
+		{
+			TilePrototype proto;
+			proto.name = palette_query.getColumn("name").getString();
+			proto.flags = palette_query.getColumn("flags").getUInt();
+			proto.set_sprite(palette_query.getColumn("sprite").getString());
+			tile_palette.push_back(proto);
+		}
+		if (fill_id >= tile_palette.size()) guru::halt("Invalid tile palette for dungeon ID " + strx::uitos(id));
+		fill(tile_palette.at(fill_id));
+
+		// The rooms need to be in place before the chunks are loaded, so the chunks can fill in their free cells.
+		SQLite::Statement room_query(*world::save_db(), "SELECT * FROM rooms WHERE dungeon_id = ?");
+		room_query.bind(1, static_cast<signed long long>(id));
+		while (room_query.executeStep())
+		{
+			const unsigned int room_id = room_query.getColumn("id").getUInt();
+			if (!room_id || room_id >= USHRT_MAX) guru::halt("Invalid room data for dungeon ID " + strx::uitos(id));
+			if (room_id >= rooms.size()) rooms.resize(room_id + 1);
+			DungeonRoom &room = rooms.at(room_id);
+			room.corridor = room_query.getColumn("corridor").getUInt();
+			room.x = room_query.getColumn("x").getUInt();
+			room.y = room_query.getColumn("y").getUInt();
+			room.w = room_query.getColumn("w").getUInt();
+			room.h = room_query.getColumn("h").getUInt();
+			room.free_cells.resize(width, room.x, room.y, room.w, room.h);
+		}
+		SQLite::Statement doorway_query(*world::save_db(), "SELECT * FROM doorways WHERE dungeon_id = ?");
+		doorway_query.bind(1, static_cast<signed long long>(id));
+		while (doorway_query.executeStep())
+		{
+			const unsigned int room_id = doorway_query.getColumn("room").getUInt();
+			const unsigned int target = doorway_query.getColumn("target").getUInt();
+			if (!room_id || room_id >= rooms.size() || !target || target >= rooms.size()) guru::halt("Invalid room data for dungeon ID " + strx::uitos(id));
+			rooms.at(room_id).doorways.push_back(RoomDoorway(doorway_query.getColumn("x").getUInt(), doorway_query.getColumn("y").getUInt(), target));
+		}
+
+		lights.clear();
+		SQLite::Statement light_query(*world::save_db(), "SELECT * FROM lights WHERE dungeon_id = ?");
+		light_query.bind(1, static_cast<signed long long>(id));
+		while (light_query.executeStep())
+		{
+			const unsigned int light_id = light_query.getColumn("id").getUInt();
+			const unsigned short lx = light_query.getColumn("x").getUInt(), ly = light_query.getColumn("y").getUInt();
+			if (lx >= width || ly >= height) guru::halt("Invalid light source data for dungeon ID " + strx::uitos(id));
+			lights.push_back(LightSource(light_id, lx, ly, light_query.getColumn("radius").getUInt()));
+			if (light_id >= light_id_next) light_id_next = light_id + 1;
+		}
+
 		auto last_redraw = std::chrono::system_clock::now();
 		loading::loading_screen(0, "Loading Dungeon...");
-		SQLite::Statement tile_query(*world::save_db(), "SELECT * FROM tiles WHERE dungeon_id = ?");
-		tile_query.bind(1, static_cast<signed long long>(id));
-		unsigned int tile_count = 0;
-		while (tile_query.executeStep())
+		unsigned int chunk_count = 0, chunk_total = 0;
+		SQLite::Statement count_query(*world::save_db(), "SELECT COUNT(*) FROM chunks WHERE dungeon_id = ?");
+		count_query.bind(1, static_cast<signed long long>(id));
+		if (count_query.executeStep()) chunk_total = count_query.getColumn(0).getUInt();
+		SQLite::Statement chunk_query(*world::save_db(), "SELECT * FROM chunks WHERE dungeon_id = ?");
+		chunk_query.bind(1, static_cast<signed long long>(id));
+		while (chunk_query.executeStep())
 		{
 			const auto time_now = std::chrono::system_clock::now();
 			const std::chrono::duration<float> elapsed_seconds = time_now - last_redraw;
 			if (elapsed_seconds.count() >= 0.1f)
 			{
 				last_redraw = time_now;
-				const unsigned int current_percent = round((static_cast<float>(tile_count) / static_cast<float>(width * height)) * 100);
+				const unsigned int current_percent = round((static_cast<float>(chunk_count) / static_cast<float>(chunk_total)) * 100);
 				loading::loading_screen(current_percent, "Loading Dungeon...");
 			}
-			unsigned short x = tile_query.getColumn("x").getUInt();
-			unsigned short y = tile_query.getColumn("y").getUInt();
-			tile(x, y)->x = x;
-			tile(x, y)->y = y;
-			tile(x, y)->load(tile_query, id);
-			tile_count++;
-			for (auto actor : *tile(x, y)->actors())
-				if (actor->ai && actor->ai->state != AIState::NONE && actor->ai->state != AIState::SLEEPING && actor->ai->state != AIState::DEAD)
-					add_active_ai(actor->ai);
+			const unsigned int x = chunk_query.getColumn("cx").getUInt() << DUNGEON_CHUNK_SHIFT;
+			const unsigned int y = chunk_query.getColumn("cy").getUInt() << DUNGEON_CHUNK_SHIFT;
+			const SQLite::Column proto_blob = chunk_query.getColumn("proto");
+			const SQLite::Column flags_blob = chunk_query.getColumn("flags");
+			const SQLite::Column room_blob = chunk_query.getColumn("room");
+			if (x >= width || y >= height || proto_blob.getBytes() != sizeof(TileChunk::proto) || flags_blob.getBytes() != sizeof(TileChunk::flags) ||
+				room_blob.getBytes() != sizeof(TileChunk::room)) guru::halt("Invalid tile chunk data for dungeon ID " + strx::uitos(id));
+			TileChunk *the_chunk = touch_chunk(x, y);
+			memcpy(the_chunk->proto, proto_blob.getBlob(), sizeof(TileChunk::proto));
+			memcpy(the_chunk->flags, flags_blob.getBlob(), sizeof(TileChunk::flags));
+			memcpy(the_chunk->room, room_blob.getBlob(), sizeof(TileChunk::room));
+			for (unsigned int ly = 0; ly < DUNGEON_CHUNK_SIZE && y + ly < height; ly++)
+			{
+				for (unsigned int lx = 0; lx < DUNGEON_CHUNK_SIZE && x + lx < width; lx++)
+				{
+					const unsigned int local = lx + (ly << DUNGEON_CHUNK_SHIFT);
+					if (the_chunk->proto[local] >= tile_palette.size()) guru::halt("Invalid tile chunk data for dungeon ID " + strx::uitos(id));
+					refresh_tile(x + lx, y + ly);
+				}
+			}
+			chunk_count++;
+		}
+
+		// The neighbour masks can only be worked out once all the chunks are in place.
+		for (unsigned int i = 0; i < chunks.size(); i++)
+			if (chunks.at(i)) recalc_chunk_masks(i);
+
+		SQLite::Statement actor_query(*world::save_db(), "SELECT id FROM actors WHERE owner = ?");
+		actor_query.bind(1, static_cast<signed long long>(id));
+		while (actor_query.executeStep())
+		{
+			auto new_actor = std::make_shared<Actor>(actor_query.getColumn("id").getInt64());
+			new_actor->load(id);
+			tile(new_actor->x, new_actor->y).add_actor(new_actor);
+			if (new_actor->ai && new_actor->ai->state != AIState::NONE && new_actor->ai->state != AIState::SLEEPING && new_actor->ai->state != AIState::DEAD)
+				add_active_ai(new_actor->ai);
 		}
 	}
 	catch(std::exception &e)
@@ -402,6 +923,34 @@ void Dungeon::load()
 	}
 }
 
+// Checks line-of-sight for a batch of queries at once, using precomputed rays. Each query follows the same line as los_check(), but is checked against the opacity bitboard, so Actors which block
+// line-of-sight (such as closed doors) are taken into account. Queries with either end outside the map always fail.
+void Dungeon::los_batch(const vector<LOSQuery> &queries, vector<bool> &results) const
+{
+	STACK_TRACE();
+	if (!los_rays.range()) los_rays.build(LOS_RAY_RANGE);
+	const int range = los_rays.range();
+	results.assign(queries.size(), false);
+	for (unsigned int i = 0; i < queries.size(); i++)
+	{
+		// Both ends are on the map, and a ray never leaves the rectangle between its ends, so no further bounds checks are needed.
+		const LOSQuery &query = queries[i];
+		if (query.x1 >= width || query.y1 >= height || query.x2 >= width || query.y2 >= height) continue;
+		const int dx = query.x2 - query.x1, dy = query.y2 - query.y1;
+		if (abs(dx) > range || abs(dy) > range)
+		{
+			results[i] = RayTable::walk(dx, dy, [this, &query](int x, int y) { return !opaque_bits.get(query.x1 + x, query.y1 + y); });
+			continue;
+		}
+		unsigned int length;
+		const RayStep *steps = los_rays.ray(dx, dy, length);
+		bool clear = true;
+		for (unsigned int s = 0; s < length && clear; s++)
+			if (opaque_bits.get(query.x1 + steps[s].x, query.y1 + steps[s].y)) clear = false;
+		results[i] = clear;
+	}
+}
+
 // Checks to see if a given tile is within the player's line of sight; optional x2/y2 coordinates can specify another non-player origin.
 // Yes, x2/y2 is used as the origin for the player, but it shouldn't matter either way - if all is working correctly, a LoS check should be symmetrical.
 // Largely adapted from Bresenham's Line Algorithm on RogueBasin.
@@ -443,7 +992,7 @@ bool Dungeon::los_check(unsigned short x1, unsigned short y1, unsigned short x2,
 
 			// We're not calling contains_los_blocker() here, as this function is used to see if a tile would be within a player's
 			// line of sight, for calculating things like dynamic lighting.
-			if (tile(x1, y1)->is_opaque()) return false;
+			if (tile(x1, y1).is_opaque()) return false;
 		}
 	}
 	else
@@ -464,7 +1013,7 @@ bool Dungeon::los_check(unsigned short x1, unsigned short y1, unsigned short x2,
 			error += delta_x;
 			y1 += iy;
 
-			if (tile(x1, y1)->is_opaque()) return false;
+			if (tile(x1, y1).is_opaque()) return false;
 		}
 	}
 
@@ -489,132 +1038,274 @@ void Dungeon::map_view(bool see_all)
 	}
 }
 
-// Picks a viable random starting location.
-void Dungeon::random_start_position(unsigned short &x, unsigned short &y) const
+// Check if a neighbour is an identical tile.
+bool Dungeon::neighbour_identical(unsigned short proto, int x, int y) const
 {
-	STACK_TRACE();
-	while(true)
-	{
-		x = mathx::rnd(width - 4) + 2;
-		y = mathx::rnd(height - 4) + 2;
-		if (tile(x, y)->is_floor()) return;
-	}
+	if (x < 0 || y < 0 || x >= width || y >= height) return false;
+	const unsigned short neighbour_proto = proto_at(x, y);
+	if (proto == neighbour_proto) return true;
+	return tile_palette[neighbour_proto].sprite_id == tile_palette[proto].sprite_id;
 }
 
-// Recalculates a specific light source.
-void Dungeon::recalc_light_source(unsigned short x, unsigned short y, unsigned short radius, bool always_visible)
+// Checks nearby tiles to modify floor and wall sprites. The result is an index into TilePrototype::sprite_variants.
+unsigned char Dungeon::neighbour_mask(unsigned short x, unsigned short y) const
 {
-	STACK_TRACE();
-	for (unsigned int i = 0; i < 8; i++)
-		cast_light(x, y, radius, 1, 1.0, 0.0, shadowcast_multipliers[0][i], shadowcast_multipliers[1][i], shadowcast_multipliers[2][i], shadowcast_multipliers[3][i], always_visible);
-	lighting[x + y * width] = 255;
+	const unsigned short proto = proto_at(x, y);
+	unsigned char neighbours = 0;
+	if (neighbour_identical(proto, x, y - 1)) neighbours += 1;
+	if (neighbour_identical(proto, x - 1, y)) neighbours += 2;
+	if (neighbour_identical(proto, x + 1, y)) neighbours += 4;
+	if (neighbour_identical(proto, x, y + 1)) neighbours += 8;
+	return neighbours;
+}
 
-	while (dynamic_light_temp.size())
-	{
-		auto iterator = dynamic_light_temp.begin();
-		std::pair<unsigned short, unsigned short> xy = *iterator;
-		dynamic_light_temp.erase(iterator);
+// Starts a new pass of the dynamic lighting system, forgetting which tiles were lit by the last one.
+void Dungeon::new_light_pass()
+{
+	dynamic_light_temp.clear();
+	if (++dynamic_light_epoch) return;
 
-		if (!always_visible && tile(xy.first, xy.second)->is_opaque())
-		{
-			if (los_check(xy.first, xy.second)) dynamic_light_temp_walls.insert(xy);
-		} else
+	// The epoch counter has wrapped around, so the stamps need to be cleared for real.
+	for (auto &stamp_chunk : dynamic_light_stamp)
+		std::fill(stamp_chunk.begin(), stamp_chunk.end(), 0);
+	dynamic_light_epoch = 1;
+}
+
+// Finds or adds a TilePrototype in this Dungeon's palette.
+unsigned short Dungeon::palette_id(const TilePrototype &proto)
+{
+	// Tile types from the static data can be found by their ID, without having to compare any names.
+	if (proto.id < tile_palette_lookup.size() && tile_palette_lookup[proto.id] != USHRT_MAX) return tile_palette_lookup[proto.id];
+
+	STACK_TRACE();
+	unsigned short result = USHRT_MAX;
+	for (unsigned int i = 0; i < tile_palette.size(); i++)
+	{
+		if (tile_palette.at(i).sprite_id == proto.sprite_id && tile_palette.at(i).name == proto.name)
 		{
-			float distance = mathx::grid_dist(x, y, xy.first, xy.second);
-			unsigned int total_light = lighting[xy.first + xy.second * width] + diminish_light(distance, 1.05f);
-			if (total_light > 255) total_light = 255;
-			lighting[xy.first + xy.second * width] = total_light;
+			result = i;
+			break;
 		}
 	}
+	if (result == USHRT_MAX)
+	{
+		if (tile_palette.size() >= USHRT_MAX) guru::halt("Too many tile types in dungeon palette!");
+		tile_palette.push_back(proto);
+		result = tile_palette.size() - 1;
+	}
+	if (proto.id != STATIC_ID_NONE)
+	{
+		if (proto.id >= tile_palette_lookup.size()) tile_palette_lookup.resize(proto.id + 1, USHRT_MAX);
+		tile_palette_lookup.at(proto.id) = result;
+	}
+	return result;
+}
+
+// Returns the palette index of a specified tile.
+unsigned short Dungeon::proto_at(unsigned short x, unsigned short y) const
+{
+	const TileChunk *the_chunk = chunk(x, y);
+	if (the_chunk) return the_chunk->proto[local_index(x, y)];
+	return fill_proto;
+}
 
-	// Brute-force check: look at all the *visible* (to the player) tiles surrounding the wall, and pick the brightest.
-	for (auto xy : dynamic_light_temp_walls)
+// Picks a viable random starting location.
+void Dungeon::random_start_position(unsigned short &x, unsigned short &y) const
+{
+	STACK_TRACE();
+	const unsigned int cell = free_cells.random();
+	if (cell == UINT_MAX) guru::halt("Could not find a viable starting position!");
+	x = cell % width;
+	y = cell / width;
+}
+
+// Recalculates the neighbour masks for every tile in a chunk.
+void Dungeon::recalc_chunk_masks(unsigned int chunk_id)
+{
+	STACK_TRACE();
+	TileChunk *the_chunk = chunks.at(chunk_id).get();
+	const unsigned int x = (chunk_id % chunk_cols) << DUNGEON_CHUNK_SHIFT;
+	const unsigned int y = (chunk_id / chunk_cols) << DUNGEON_CHUNK_SHIFT;
+	for (unsigned int ly = 0; ly < DUNGEON_CHUNK_SIZE && y + ly < height; ly++)
+		for (unsigned int lx = 0; lx < DUNGEON_CHUNK_SIZE && x + lx < width; lx++)
+			the_chunk->neighbours[lx + (ly << DUNGEON_CHUNK_SHIFT)] = neighbour_mask(x + lx, y + ly);
+}
+
+// Recalculates the light map for a static light source.
+// Light maps aren't recalculated when the camera moves, so they always cover the light's full radius; the clipping used for the hero's light is turned off while they're cast.
+void Dungeon::recalc_light_map(LightSource &light)
+{
+	STACK_TRACE();
+	const bool was_clipping = light_clipping;
+	light_clipping = false;
+	new_light_pass();
+	for (unsigned int i = 0; i < 8; i++)
+		cast_light(light.x, light.y, light.radius, 1, 1.0, 0.0, shadowcast_multipliers[0][i], shadowcast_multipliers[1][i], shadowcast_multipliers[2][i], shadowcast_multipliers[3][i], true);
+	light_clipping = was_clipping;
+	light.light_map.clear();
+	light.walls.clear();
+	light.light_map.push_back(std::pair<unsigned int, unsigned char>(light.x + light.y * width, 255));
+	for (auto index : dynamic_light_temp)
 	{
-		unsigned char brightest = 30;
-		for (short dx = -1; dx <= 1; dx++)
+		const unsigned short lx = index % width, ly = index / width;
+		if (opaque_bits.get(lx, ly)) light.walls.push_back(index);
+		else
 		{
-			if (dx + xy.first < 0 || dx + xy.first >= width) continue;
-			for (short dy = -1; dy <= 1; dy++)
-			{
-				if ((dx == 0 && dy == 0) || dy + xy.second < 0 || dy + xy.second >= height) continue;
-				if (tile(xy.first + dx, xy.second + dy)->is_opaque()) continue;
-				if (!los_check(xy.first + dx, xy.second + dy)) continue;
-				unsigned char light = lighting[xy.first + dx + (xy.second + dy) * width];
-				if (light > brightest) brightest = light;
-			}
+			const int dx = lx - light.x, dy = ly - light.y;
+			light.light_map.push_back(std::pair<unsigned int, unsigned char>(index, diminish_light_sq(dx * dx + dy * dy)));
 		}
-		lighting[xy.first + xy.second * width] = brightest;
 	}
-
 	dynamic_light_temp.clear();
-	dynamic_light_temp_walls.clear();
+	light.dirty = false;
 }
 
-// Clears the lighting array and recalculates all light sources.
-void Dungeon::recalc_lighting()
+// Recalculates the hero's light within a single shadowcasting octant.
+void Dungeon::recalc_hero_octant(unsigned int octant)
 {
 	STACK_TRACE();
-	memset(lighting, 0, sizeof(unsigned char) * width * height);
-	recalc_light_source(world::hero()->x, world::hero()->y, 100, true);
+	vector<unsigned int> &lit = hero_light_cells[octant];
+	for (auto cell : lit)
+	{
+		set_light(cell % width, cell / width, 0);
+		hero_fov_bits.set(cell % width, cell / width, false);
+	}
+	lit.clear();
+	new_light_pass();
+	cast_light(light_origin_x, light_origin_y, HERO_LIGHT_RADIUS, 1, 1.0, 0.0, shadowcast_multipliers[0][octant], shadowcast_multipliers[1][octant], shadowcast_multipliers[2][octant],
+		shadowcast_multipliers[3][octant], true);
+	for (auto index : dynamic_light_temp)
+	{
+		const unsigned short lx = index % width, ly = index / width;
+		const int dx = lx - light_origin_x, dy = ly - light_origin_y;
+		set_light(lx, ly, diminish_light_sq(dx * dx + dy * dy));
+		hero_fov_bits.set(lx, ly, true);
+	}
+	lit.swap(dynamic_light_temp);
 }
 
-// Flood-fills a specified area with a new region ID.
-void Dungeon::region_floodfill(unsigned short x, unsigned short y, unsigned int new_region)
+// Recalculates the lighting, only redoing the parts of it which could have changed.
+// If the hero hasn't moved, the only thing that can change the lighting is a tile changing opacity, and that can only affect the octants the tile is in.
+// If the hero has moved at all, every ray is different, so it all has to be done again.
+// The static light sources are blended on top of the hero's light afterwards; a light source only has to recalculate its own light map if a tile within its radius has changed opacity.
+void Dungeon::recalc_lighting()
 {
 	STACK_TRACE();
-	if (region[x + y * width] == new_region) return;
-	if (tile(x, y)->is_wall()) return;
+	const unsigned short hero_x = world::hero()->x, hero_y = world::hero()->y;
+	const bool reset = (light_origin_x == USHRT_MAX);
+
+	// When culling, the hero's light only needs to cover the part of the map on the screen, plus a margin so the camera can move a little without needing everything recalculated.
+	unsigned short view_x1 = 0, view_y1 = 0, view_x2 = width - 1, view_y2 = height - 1;
+	const bool culling = light_culling && view_bounds(view_x1, view_y1, view_x2, view_y2);
+	bool clip_stale = (culling != light_clipping);
+	if (culling && (view_x1 < light_clip_x1 || view_y1 < light_clip_y1 || view_x2 > light_clip_x2 || view_y2 > light_clip_y2)) clip_stale = true;
+	const bool hero_moved = (hero_x != light_origin_x || hero_y != light_origin_y || clip_stale);
+	bool lights_dirty = lights_changed;
+	for (auto &light : lights)
+	{
+		if (reset) light.dirty = true;
+		for (unsigned int i = 0; i < light_dirty.size() && !light.dirty; i++)
+		{
+			const int dx = static_cast<int>(light_dirty.at(i) % width) - light.x, dy = static_cast<int>(light_dirty.at(i) / width) - light.y;
+			if (dx * dx + dy * dy <= light.radius * light.radius) light.dirty = true;
+		}
+		if (light.dirty) lights_dirty = true;
+	}
+	if (!hero_moved && !light_dirty.size() && !lights_dirty) return;
+	unblend_lights();
+	lights_changed = false;
+	if (hero_moved || light_dirty.size()) hero_fov_generation++;
 
-	region[x + y * width] = new_region;
-	for (short dx = -1; dx <= 1; dx++)
+	if (hero_moved)
 	{
-		for (short dy = -1; dy <= 1; dy++)
+		for (auto &light_chunk : light_chunks)
+			std::fill(light_chunk.begin(), light_chunk.end(), 0);
+		hero_fov_bits.fill(false);
+		light_clipping = culling;
+		light_clip_x1 = (culling ? std::max(view_x1 - light_cull_margin, 0) : 0);
+		light_clip_y1 = (culling ? std::max(view_y1 - light_cull_margin, 0) : 0);
+		light_clip_x2 = (culling ? std::min(view_x2 + light_cull_margin, width - 1) : width - 1);
+		light_clip_y2 = (culling ? std::min(view_y2 + light_cull_margin, height - 1) : height - 1);
+		for (unsigned int i = 0; i < 8; i++)
+			hero_light_cells[i].clear();
+		light_origin_x = hero_x;
+		light_origin_y = hero_y;
+		for (unsigned int i = 0; i < 8; i++)
+			recalc_hero_octant(i);
+	}
+	else if (light_dirty.size())
+	{
+		// Work out which octants each changed tile falls within. The multipliers form a signed permutation matrix, so the transpose maps a tile back into octant space.
+		bool octant_dirty[8] = { false };
+		for (auto cell : light_dirty)
 		{
-			if (dx != 0 && dy != 0) continue;
-			if (region[x + dx + (y + dy) * width] != new_region) region_floodfill(x + dx, y + dy, new_region);
+			const int sx = static_cast<int>(cell % width) - hero_x, sy = static_cast<int>(cell / width) - hero_y;
+			for (unsigned int i = 0; i < 8; i++)
+			{
+				const int dx = sx * shadowcast_multipliers[0][i] + sy * shadowcast_multipliers[2][i];
+				const int dy = sx * shadowcast_multipliers[1][i] + sy * shadowcast_multipliers[3][i];
+				if (dy <= -1 && dx >= dy && dx <= 0) octant_dirty[i] = true;
+			}
+		}
+		for (unsigned int i = 0; i < 8; i++)
+			if (octant_dirty[i]) recalc_hero_octant(i);
+
+		// Tiles along the edge of an octant are shared with its neighbour, so any that were just cleared need to be lit again from the octants that didn't change.
+		for (unsigned int i = 0; i < 8; i++)
+		{
+			if (octant_dirty[i]) continue;
+			for (auto cell : hero_light_cells[i])
+			{
+				const unsigned short cx = cell % width, cy = cell / width;
+				const int sx = cx - hero_x, sy = cy - hero_y;
+				if (sx && sy && abs(sx) != abs(sy)) continue;
+				set_light(cx, cy, diminish_light_sq(sx * sx + sy * sy));
+				hero_fov_bits.set(cx, cy, true);
+			}
 		}
 	}
+	light_dirty.clear();
+	set_light(hero_x, hero_y, 255);
+	hero_fov_bits.set(hero_x, hero_y, true);
+	blend_lights();
 }
 
 // Renders the dungeon on the screen.
 void Dungeon::render(bool see_all)
 {
 	STACK_TRACE();
+	recalc_lighting();	// If the camera has moved outside of the area the lighting was calculated for, this will catch it; otherwise it costs nothing.
 	iocore::cls();
+	const shared_ptr<Hero> hero = world::hero();
 	for (unsigned int x = 0; x < width; x++)
 	{
-		int screen_x = static_cast<signed int>(x) + world::hero()->camera_off_x;
+		int screen_x = static_cast<signed int>(x) + hero->camera_off_x;
 		if (screen_x < 0 || static_cast<unsigned int>(screen_x) >= iocore::get_tile_cols()) continue;
 		for (unsigned int y = 0; y < height; y++)
 		{
-			int screen_y = static_cast<signed int>(y) + world::hero()->camera_off_y;
+			int screen_y = static_cast<signed int>(y) + hero->camera_off_y;
 			if (screen_y < 0 || static_cast<unsigned int>(screen_y) >= iocore::get_tile_rows()) continue;
 #
-			Tile* here = tile(x, y);
-			unsigned char here_brightness = lighting[x + y * width];
+			const Tile here = tile(x, y);
+			unsigned char here_brightness = light_at(x, y);
 			if (see_all && here_brightness < 50) here_brightness = 50;
 			if (here_brightness >= 50)
 			{
-				shared_ptr<Actor> actor_here = nullptr;
-				const auto actors = here->actors();
-				if (actors)
+				Actor *actor_here = nullptr;
+				for (auto actor : here.actors())
 				{
-					for (auto actor : *actors)
+					if (actor->is_invisible()) continue;
+					if (actor_here)
 					{
-						if (actor->is_invisible()) continue;
-						if (actor_here)
-						{
-							if (actor_here->has_low_priority_rendering() && !actor->has_low_priority_rendering()) actor_here = actor;
-						}
-						else actor_here = actor;
+						if (actor_here->has_low_priority_rendering() && !actor->has_low_priority_rendering()) actor_here = actor;
 					}
+					else actor_here = actor;
 				}
-				iocore::print_tile(here->get_sprite(), screen_x, screen_y, here_brightness);
-				if (x == world::hero()->x && y == world::hero()->y) iocore::print_tile(world::hero()->sprite, screen_x, screen_y, here_brightness, true);
+				iocore::print_tile(here.get_sprite(), screen_x, screen_y, here_brightness);
+				if (x == hero->x && y == hero->y) iocore::print_tile(hero->sprite, screen_x, screen_y, here_brightness, true);
 				else if (actor_here) iocore::print_tile(actor_here->sprite, screen_x, screen_y, here_brightness, actor_here->is_animated());
 				explore(x, y);
 			}
-			else if (here->is_explored()) iocore::print_tile(here->get_sprite(), screen_x, screen_y, 50);
+			else if (here.is_explored()) iocore::print_tile(here.get_sprite(), screen_x, screen_y, 50);
 		}
 	}
 }
@@ -628,27 +1319,166 @@ void Dungeon::save()
 		SQLite::Statement clear_dungeon(*world::save_db(), "DELETE FROM dungeon WHERE id = ?");
 		clear_dungeon.bind(1, static_cast<signed long long>(id));
 		clear_dungeon.exec();
-		SQLite::Statement clear_tiles(*world::save_db(), "DELETE FROM tiles WHERE dungeon_id = ?");
-		clear_tiles.bind(1, static_cast<signed long long>(id));
-		clear_tiles.exec();
-
-		SQLite::Statement statement(*world::save_db(), "INSERT INTO dungeon (id, width, height) VALUES (?, ?, ?)");
+		SQLite::Statement clear_palette(*world::save_db(), "DELETE FROM palette WHERE dungeon_id = ?");
+		clear_palette.bind(1, static_cast<signed long long>(id));
+		clear_palette.exec();
+		SQLite::Statement clear_rooms(*world::save_db(), "DELETE FROM rooms WHERE dungeon_id = ?");
+		clear_rooms.bind(1, static_cast<signed long long>(id));
+		clear_rooms.exec();
+		SQLite::Statement clear_doorways(*world::save_db(), "DELETE FROM doorways WHERE dungeon_id = ?");
+		clear_doorways.bind(1, static_cast<signed long long>(id));
+		clear_doorways.exec();
+		SQLite::Statement clear_lights(*world::save_db(), "DELETE FROM lights WHERE dungeon_id = ?");
+		clear_lights.bind(1, static_cast<signed long long>(id));
+		clear_lights.exec();
+
+		SQLite::Statement statement(*world::save_db(), "INSERT INTO dungeon (id, width, height, fill) VALUES (?, ?, ?, ?)");
 		statement.bind(1, static_cast<signed long long>(id));
 		statement.bind(2, width);
 		statement.bind(3, height);
+		statement.bind(4, fill_proto);
 		statement.exec();
+
+		SQLite::Statement palette_statement(*world::save_db(), "INSERT INTO palette (dungeon_id, id, name, sprite, flags) VALUES (?, ?, ?, ?, ?)");
+		for (unsigned int i = 0; i < tile_palette.size(); i++)
+		{
+			palette_statement.bind(1, static_cast<signed long long>(id));
+			palette_statement.bind(2, i);
+			palette_statement.bind(3, tile_palette.at(i).name);
+			palette_statement.bind(4, atom::name(tile_palette.at(i).sprite_id));
+			palette_statement.bind(5, tile_palette.at(i).flags);
+			palette_statement.exec();
+			palette_statement.reset();
+		}
+
+		SQLite::Statement room_statement(*world::save_db(), "INSERT INTO rooms (dungeon_id, id, x, y, w, h, corridor) VALUES (?, ?, ?, ?, ?, ?, ?)");
+		SQLite::Statement doorway_statement(*world::save_db(), "INSERT INTO doorways (dungeon_id, room, x, y, target) VALUES (?, ?, ?, ?, ?)");
+		for (unsigned int i = 1; i < rooms.size(); i++)
+		{
+			const DungeonRoom &room = rooms.at(i);
+			room_statement.bind(1, static_cast<signed long long>(id));
+			room_statement.bind(2, i);
+			room_statement.bind(3, room.x);
+			room_statement.bind(4, room.y);
+			room_statement.bind(5, room.w);
+			room_statement.bind(6, room.h);
+			room_statement.bind(7, room.corridor);
+			room_statement.exec();
+			room_statement.reset();
+			for (auto doorway : room.doorways)
+			{
+				doorway_statement.bind(1, static_cast<signed long long>(id));
+				doorway_statement.bind(2, i);
+				doorway_statement.bind(3, doorway.x);
+				doorway_statement.bind(4, doorway.y);
+				doorway_statement.bind(5, doorway.target);
+				doorway_statement.exec();
+				doorway_statement.reset();
+			}
+		}
+
+		SQLite::Statement light_statement(*world::save_db(), "INSERT INTO lights (dungeon_id, id, x, y, radius) VALUES (?, ?, ?, ?, ?)");
+		for (auto &light : lights)
+		{
+			light_statement.bind(1, static_cast<signed long long>(id));
+			light_statement.bind(2, light.id);
+			light_statement.bind(3, light.x);
+			light_statement.bind(4, light.y);
+			light_statement.bind(5, light.radius);
+			light_statement.exec();
+			light_statement.reset();
+		}
+
+		// Only chunks which have changed since the last save need to be written. Chunks which were never allocated are just the fill tile, and aren't saved at all.
+		SQLite::Statement chunk_statement(*world::save_db(), "INSERT OR REPLACE INTO chunks (dungeon_id, cx, cy, proto, flags, room) VALUES (?, ?, ?, ?, ?, ?)");
+		for (unsigned int i = 0; i < chunks.size(); i++)
+		{
+			TileChunk *the_chunk = chunks.at(i).get();
+			if (!the_chunk || !the_chunk->dirty) continue;
+			chunk_statement.bind(1, static_cast<signed long long>(id));
+			chunk_statement.bind(2, i % chunk_cols);
+			chunk_statement.bind(3, i / chunk_cols);
+			chunk_statement.bind(4, the_chunk->proto, sizeof(TileChunk::proto));
+			chunk_statement.bind(5, the_chunk->flags, sizeof(TileChunk::flags));
+			chunk_statement.bind(6, the_chunk->room, sizeof(TileChunk::room));
+			chunk_statement.exec();
+			chunk_statement.reset();
+			the_chunk->dirty = false;
+		}
 	}
 	catch(std::exception &e)
 	{
 		guru::halt(e.what());
 	}
-	for (unsigned int x = 0; x < width; x++)
-		for (unsigned int y = 0; y < height; y++)
-			tile(x, y)->save(id);
+	for (const auto &tile_contents : tile_actors)
+		for (auto actor : tile_contents.second)
+			actor->save(id);
 }
 
-// Sets a specified tile, with error checking.
-void Dungeon::set_tile(unsigned short x, unsigned short y, Tile &new_tile)
+// Removes a static light source.
+void Dungeon::remove_light(unsigned int light_id)
+{
+	STACK_TRACE();
+	for (unsigned int i = 0; i < lights.size(); i++)
+	{
+		if (lights.at(i).id != light_id) continue;
+		lights.erase(lights.begin() + i);
+		lights_changed = true;
+		return;
+	}
+	guru::nonfatal("Attempted to remove invalid light source ID: " + strx::uitos(light_id), GURU_ERROR);
+}
+
+// Updates the bitboards and cell indices for a tile, after its flags or Actors have changed.
+void Dungeon::refresh_tile(unsigned short x, unsigned short y)
+{
+	STACK_TRACE();
+	const unsigned int index = x + y * width;
+	const unsigned char flags = flags_at(x, y);
+	bool blocker = false, los_blocker = false;
+	auto found = tile_actors.find(index);
+	if (found != tile_actors.end())
+	{
+		for (auto actor : found->second)
+		{
+			if (actor->is_blocker()) blocker = true;
+			if (actor->is_los_blocker()) los_blocker = true;
+		}
+	}
+	blocker_bits.set(x, y, blocker);
+	impassible_bits.set(x, y, flags & TILE_FLAG_IMPASSIBLE);
+	const bool opaque = los_blocker || (flags & TILE_FLAG_OPAQUE);
+	if (opaque != opaque_bits.get(x, y))
+	{
+		opaque_bits.set(x, y, opaque);
+		if (light_origin_x != USHRT_MAX) light_dirty.push_back(index);
+	}
+
+	const bool walkable = !(flags & TILE_FLAG_IMPASSIBLE);
+	const bool empty = walkable && found == tile_actors.end();
+	const unsigned short room = room_at(x, y);
+	if (walkable) walkable_cells.add(index);
+	else walkable_cells.remove(index);
+	if (empty) free_cells.add(index);
+	else free_cells.remove(index);
+	if (room)
+	{
+		if (room >= rooms.size()) rooms.resize(room + 1);
+		if (empty) rooms.at(room).free_cells.add(index);
+		else rooms.at(room).free_cells.remove(index);
+	}
+}
+
+// Returns the room ID of a specified tile, or 0 if it isn't part of any room or corridor.
+unsigned short Dungeon::room_at(unsigned short x, unsigned short y) const
+{
+	const TileChunk *the_chunk = chunk(x, y);
+	if (the_chunk) return the_chunk->room[local_index(x, y)];
+	return 0;
+}
+
+// Sets a specified tile, with error checking. Any Actors on the tile are unaffected, as they are stored separately.
+void Dungeon::set_tile(unsigned short x, unsigned short y, const TilePrototype &new_tile)
 {
 	STACK_TRACE();
 	if (x >= width || y >= height)
@@ -656,18 +1486,89 @@ void Dungeon::set_tile(unsigned short x, unsigned short y, Tile &new_tile)
 		guru::nonfatal("Attempted to set out-of-bounds tile.", GURU_CRITICAL);
 		return;
 	}
+	const unsigned short new_proto = palette_id(new_tile);
+	TileChunk *the_chunk = chunk(x, y);
+	if (!the_chunk)
+	{
+		if (new_proto == fill_proto && new_tile.flags == fill_flags) return;	// Nothing to do; the tile is already the fill tile.
+		the_chunk = touch_chunk(x, y);
+	}
+	const unsigned short local = local_index(x, y);
+	if (the_chunk->flags[local] != new_tile.flags)
+	{
+		the_chunk->flags[local] = new_tile.flags;
+		the_chunk->dirty = true;
+		refresh_tile(x, y);
+	}
+	if (the_chunk->proto[local] == new_proto) return;
+	the_chunk->proto[local] = new_proto;
+	the_chunk->dirty = true;
+	update_neighbour_masks(x, y);
+}
+
+// Sets the light level of a specified tile. Chunks with no light data are always dark, so the light data for a chunk is only allocated when a tile within it becomes lit.
+void Dungeon::set_light(unsigned short x, unsigned short y, unsigned char light)
+{
+	vector<unsigned char> &light_chunk = light_chunks[chunk_index(x, y)];
+	if (!light_chunk.size())
+	{
+		if (!light) return;
+		light_chunk.assign(DUNGEON_CHUNK_AREA, 0);
+	}
+	light_chunk[local_index(x, y)] = light;
+}
 
-	Tile* old_tile = tile(x, y);
-	vector<shared_ptr<Actor>> old_actors;
-	for (auto actor : *old_tile->actors())
-		old_actors.push_back(actor);
+// Sets the room ID of a specified tile.
+void Dungeon::set_room(unsigned short x, unsigned short y, unsigned short room)
+{
+	STACK_TRACE();
+	if (x >= width || y >= height)
+	{
+		guru::nonfatal("Attempted to set room on out-of-bounds tile.", GURU_CRITICAL);
+		return;
+	}
+	TileChunk *the_chunk = (room ? touch_chunk(x, y) : chunk(x, y));
+	const unsigned int local = local_index(x, y);
+	if (!the_chunk || the_chunk->room[local] == room) return;
+	const unsigned short old_room = the_chunk->room[local];
+	if (old_room && old_room < rooms.size()) rooms.at(old_room).free_cells.remove(x + y * width);
+	the_chunk->room[local] = room;
+	the_chunk->dirty = true;
+	refresh_tile(x, y);
+}
 
-	tiles[x + y * width] = new_tile;
-	tiles[x + y * width].x = x;
-	tiles[x + y * width].y = y;
+// Marks a tile as reached by the current lighting pass, returning false if it already was.
+bool Dungeon::stamp_light(unsigned short x, unsigned short y)
+{
+	vector<unsigned int> &stamp_chunk = dynamic_light_stamp[chunk_index(x, y)];
+	if (!stamp_chunk.size()) stamp_chunk.assign(DUNGEON_CHUNK_AREA, 0);
+	unsigned int &stamp = stamp_chunk[local_index(x, y)];
+	if (stamp == dynamic_light_epoch) return false;
+	stamp = dynamic_light_epoch;
+	return true;
+}
 
-	for (auto actor : old_actors)
-		tiles[x + y * width].actors()->push_back(actor);
+// Rebuilds everything dropped by freeze(), ready for this level to become the current one again.
+void Dungeon::thaw()
+{
+	STACK_TRACE();
+	if (!frozen) return;
+	frozen = false;
+	dynamic_light_epoch = 0;
+	dynamic_light_stamp.assign(chunks.size(), vector<unsigned int>());
+	light_chunks.assign(chunks.size(), vector<unsigned char>());
+	blocker_bits.resize(width, height);
+	hero_fov_bits.resize(width, height);
+	impassible_bits.resize(width, height);
+	opaque_bits.resize(width, height);
+	free_cells.resize(width, 0, 0, width, height);
+	walkable_cells.resize(width, 0, 0, width, height);
+	for (auto &room : rooms)
+		room.free_cells.resize(width, room.x, room.y, room.w, room.h);
+	for (unsigned short x = 0; x < width; x++)
+		for (unsigned short y = 0; y < height; y++)
+			refresh_tile(x, y);
+	hero_fov_generation++;
 }
 
 // Runs any active AI in this Dungeon.
@@ -688,12 +1589,22 @@ void Dungeon::tick_ai()
 	}
 }
 
-// Retrieves a specified tile pointer.
-Tile* Dungeon::tile(unsigned short x, unsigned short y) const
+// Retrieves a view of a specified tile.
+Tile Dungeon::tile(unsigned short x, unsigned short y) const
 {
-	STACK_TRACE();
 	if (x >= width || y >= height) guru::halt("Attempted to retrieve out-of-bounds tile.");
-	return &tiles[x + y * width];
+	return Tile(const_cast<Dungeon*>(this), x, y);
+}
+
+// Returns the chunk containing a specified tile, allocating it if needed.
+TileChunk* Dungeon::touch_chunk(unsigned short x, unsigned short y)
+{
+	const unsigned int chunk_id = chunk_index(x, y);
+	if (chunks[chunk_id]) return chunks[chunk_id].get();
+	STACK_TRACE();
+	chunks[chunk_id] = std::make_shared<TileChunk>(fill_proto, fill_flags);
+	recalc_chunk_masks(chunk_id);
+	return chunks[chunk_id].get();
 }
 
 // Checks if this tile touches a different region.
@@ -710,27 +1621,56 @@ bool Dungeon::touches_two_regions(unsigned short x, unsigned short y) const
 	return false;
 }
 
+// Takes the light from the static light sources off again, leaving only the hero's light.
+void Dungeon::unblend_lights()
+{
+	STACK_TRACE();
+	for (auto it = light_blend.rbegin(); it != light_blend.rend(); ++it)
+	{
+		const unsigned short lx = it->first % width, ly = it->first / width;
+		set_light(lx, ly, light_at(lx, ly) - it->second);
+	}
+	light_blend.clear();
+}
+
+// Updates the neighbour masks around a tile which has changed. Only the tile itself and its orthogonal neighbours can be affected.
+// Tiles in unallocated chunks don't store a mask at all; it is worked out when needed instead.
+void Dungeon::update_neighbour_masks(unsigned short x, unsigned short y)
+{
+	for (short dx = -1; dx <= 1; dx++)
+	{
+		for (short dy = -1; dy <= 1; dy++)
+		{
+			if (dx != 0 && dy != 0) continue;
+			const int nx = x + dx, ny = y + dy;
+			if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+			TileChunk *the_chunk = chunk(nx, ny);
+			if (the_chunk) the_chunk->neighbours[local_index(nx, ny)] = neighbour_mask(nx, ny);
+		}
+	}
+}
+
 // Checks if this tile is a viable doorway.
 int Dungeon::viable_doorway(unsigned short x, unsigned short y) const
 {
 	STACK_TRACE();
 	if (x < 2 || y < 2 || x >= width - 2 || y >= height - 2) return false;
-	if (!tile(x, y)->is_floor()) return false;	// Only basic floor can become a door.
-	if (tile(x, y)->has_door() != UINT_MAX) return false;	// Don't place a door where one already exists.
+	if (!tile(x, y).is_floor()) return false;	// Only basic floor can become a door.
+	if (tile(x, y).has_door() != UINT_MAX) return false;	// Don't place a door where one already exists.
 
-	if (tile(x - 1, y)->is_wall() && tile(x + 1, y)->is_wall())
+	if (tile(x - 1, y).is_wall() && tile(x + 1, y).is_wall())
 	{
-		if (tile(x, y + 1)->is_wall()) return 0;
-		if (tile(x, y - 1)->is_wall()) return 0;
-		if (!tile(x - 1, y + 1)->is_wall() && !tile(x + 1, y + 1)->is_wall()) return 1;
-		if (!tile(x - 1, y - 1)->is_wall() && !tile(x + 1, y - 1)->is_wall()) return 1;
+		if (tile(x, y + 1).is_wall()) return 0;
+		if (tile(x, y - 1).is_wall()) return 0;
+		if (!tile(x - 1, y + 1).is_wall() && !tile(x + 1, y + 1).is_wall()) return 1;
+		if (!tile(x - 1, y - 1).is_wall() && !tile(x + 1, y - 1).is_wall()) return 1;
 	}
-	else if (tile(x, y - 1)->is_wall() && tile(x, y + 1)->is_wall())
+	else if (tile(x, y - 1).is_wall() && tile(x, y + 1).is_wall())
 	{
-		if (tile(x - 1, y)->is_wall()) return 0;
-		if (tile(x + 1, y)->is_wall()) return 0;
-		if (!tile(x + 1, y - 1)->is_wall() && !tile(x + 1, y + 1)->is_wall()) return 2;
-		if (!tile(x - 1, y - 1)->is_wall() && !tile(x - 1, y + 1)->is_wall()) return 2;
+		if (tile(x - 1, y).is_wall()) return 0;
+		if (tile(x + 1, y).is_wall()) return 0;
+		if (!tile(x + 1, y - 1).is_wall() && !tile(x + 1, y + 1).is_wall()) return 2;
+		if (!tile(x - 1, y - 1).is_wall() && !tile(x - 1, y + 1).is_wall()) return 2;
 	}
 
 	return 0;
@@ -743,83 +1683,96 @@ bool Dungeon::viable_maze_position(unsigned short x, unsigned short y) const
 	if (x < 2 || y < 2 || x >= width - 2 || y >= height - 2) return false;
 
 	unsigned short current_exits = 0;
-	if (!tile(x, y)->is_wall()) return false;
+	if (!tile(x, y).is_wall()) return false;
 	for (int ox = -1; ox <= 1; ox++)
 	{
 		for (int oy = -1; oy <= 1; oy++)
 		{
 			if (ox == 0 && oy == 0) continue;
-			if (!tile(x + ox, y + oy)->is_wall()) current_exits++;
+			if (!tile(x + ox, y + oy).is_wall()) current_exits++;
 		}
 	}
 	if (current_exits <= 1) return true;
 	else return false;
 }
 
-// Checks if this is a viable position to place a new room.
-bool Dungeon::viable_room_position(unsigned short x, unsigned short y, unsigned short w, unsigned short h) const
+// Works out which part of the map is on the screen. Returns false if there's no screen, or none of the map is visible on it.
+bool Dungeon::view_bounds(unsigned short &x1, unsigned short &y1, unsigned short &x2, unsigned short &y2) const
 {
 	STACK_TRACE();
-	for (unsigned short rx = x - 1; rx < x + w + 2; rx++)
-		for (unsigned short ry = y - 1; ry < y + h + 2; ry++)
-			if (!tile(rx, ry)->is_destroyable_wall()) return false;
+	const int cols = iocore::get_tile_cols(), rows = iocore::get_tile_rows();
+	if (cols <= 0 || rows <= 0) return false;
+	const shared_ptr<Hero> hero = world::hero();
+	const int left = -hero->camera_off_x, top = -hero->camera_off_y, right = left + cols - 1, bottom = top + rows - 1;
+	if (right < 0 || bottom < 0 || left >= width || top >= height) return false;
+	x1 = std::max(left, 0);
+	y1 = std::max(top, 0);
+	x2 = std::min(right, width - 1);
+	y2 = std::min(bottom, height - 1);
 	return true;
 }
 
+// Read-only access to the Actors in this Tile.
+const TileActors& Tile::actors() const
+{
+	static const TileActors no_actors;
+	auto found = owner->tile_actors.find(index());
+	if (found == owner->tile_actors.end()) return no_actors;
+	return found->second;
+}
+
 // Adds an Actor to this Tile.
 void Tile::add_actor(shared_ptr<Actor> actor)
 {
 	STACK_TRACE();
-	contained_actors.push_back(actor);
+	owner->tile_actors[index()].push_back(actor);
 	actor->x = x;
 	actor->y = y;
-}
-
-// Checks nearby tiles to modify floor and wall sprites.
-string Tile::check_neighbours(int x, int y, bool wall) const
-{
-	STACK_TRACE();
-	const unsigned char wall_map[16] = { 5, 4, 2, 15, 2, 15, 2, 15, 4, 4, 11, 14, 11, 12, 11, 13 };
-
-	unsigned char neighbours = 0;
-	if (neighbour_identical(x, y - 1)) neighbours += 1;
-	if (neighbour_identical(x - 1, y)) neighbours += 2;
-	if (neighbour_identical(x + 1, y)) neighbours += 4;
-	if (neighbour_identical(x, y + 1)) neighbours += 8;
-
-	if (wall) return strx::itos(wall_map[neighbours]);
-	else return "5";
+	owner->actor_grid.add(actor.get());
+	owner->refresh_tile(x, y);
 }
 
 // Checks if this Tile contains an Actor that blocks line-of-sight.
 bool Tile::contains_los_blocker() const
 {
 	STACK_TRACE();
-	for (auto actor : contained_actors)
+	for (auto actor : actors())
 		if (actor->is_los_blocker()) return true;
 	return false;
 }
 
-// Returns the sprite name for rendering this tile.
-string Tile::get_sprite() const
+// Returns the flags for this Tile.
+unsigned char Tile::flags() const
 {
-	STACK_TRACE();
-	string sprite_name = sprite;
+	return owner->flags_at(x, y);
+}
 
-	if (sprite_name.size() >= 7 && sprite_name.substr(0, 6) == "FLOOR_") return sprite_name.substr(0, 7) + "_" + check_neighbours(x, y, false);
-	else if (sprite_name.size() >= 6 && sprite_name.substr(0, 5) == "WALL_") return sprite_name.substr(0, 6) + "_" + check_neighbours(x, y, true);
-	return sprite_name;
+// Returns the sprite ID for rendering this tile.
+unsigned short Tile::get_sprite() const
+{
+	STACK_TRACE();
+	const TileChunk *the_chunk = owner->chunk(x, y);
+	if (!the_chunk) return owner->tile_palette[owner->fill_proto].sprite_variants[owner->neighbour_mask(x, y)];
+	const unsigned short local = owner->local_index(x, y);
+	return owner->tile_palette[the_chunk->proto[local]].sprite_variants[the_chunk->neighbours[local]];
 }
 
 // Checks if a door is present here, and returns the Actor vector ID if so.
 unsigned int Tile::has_door() const
 {
 	STACK_TRACE();
+	const TileActors &contained_actors = actors();
 	for (unsigned int i = 0; i < contained_actors.size(); i++)
 		if (contained_actors.at(i)->is_door()) return i;
 	return UINT_MAX;
 }
 
+// The index of this Tile within the Dungeon, used as a key for its Actors.
+unsigned int Tile::index() const
+{
+	return x + y * owner->width;
+}
+
 // Is this Tile a wall that can be destroyed?
 bool Tile::is_destroyable_wall() const
 {
@@ -829,37 +1782,37 @@ bool Tile::is_destroyable_wall() const
 // Has this Tile been explored?
 bool Tile::is_explored() const
 {
-	return (flags & TILE_FLAG_EXPLORED) == TILE_FLAG_EXPLORED;
+	return (flags() & TILE_FLAG_EXPLORED) == TILE_FLAG_EXPLORED;
 }
 
 // Is this Tile a floor of some kind?
 bool Tile::is_floor() const
 {
-	return (flags & TILE_FLAG_FLOOR) == TILE_FLAG_FLOOR;
+	return (flags() & TILE_FLAG_FLOOR) == TILE_FLAG_FLOOR;
 }
 
 // Is this Tile something that blocks movement?
 bool Tile::is_impassible() const
 {
-	return (flags & TILE_FLAG_IMPASSIBLE) == TILE_FLAG_IMPASSIBLE;
+	return (flags() & TILE_FLAG_IMPASSIBLE) == TILE_FLAG_IMPASSIBLE;
 }
 
 // Does this Tile block line-of-sight?
 bool Tile::is_opaque() const
 {
-	return (flags & TILE_FLAG_OPAQUE) == TILE_FLAG_OPAQUE;
+	return (flags() & TILE_FLAG_OPAQUE) == TILE_FLAG_OPAQUE;
 }
 
 // Is this Tile a wall that can never be destroyed under any circumstances?
 bool Tile::is_permawall() const
 {
-	return (flags & TILE_FLAG_PERMAWALL) == TILE_FLAG_PERMAWALL;
+	return (flags() & TILE_FLAG_PERMAWALL) == TILE_FLAG_PERMAWALL;
 }
 
 // Is this Tile a wall of some kind?
 bool Tile::is_wall() const
 {
-	return (flags & TILE_FLAG_WALL) == TILE_FLAG_WALL;
+	return (flags() & TILE_FLAG_WALL) == TILE_FLAG_WALL;
 }
 
 // Returns a list of all contained Actors with the ACTOR_FLAG_ITEM flag.
@@ -867,90 +1820,102 @@ vector<unsigned int> Tile::items_here() const
 {
 	STACK_TRACE();
 	vector<unsigned int> result;
+	const TileActors &contained_actors = actors();
 	for (unsigned int i = 0; i < contained_actors.size(); i++)
 		if (contained_actors.at(i)->is_item()) result.push_back(i);
 	return result;
 }
 
-// Loads this Tile from disk.
-void Tile::load(SQLite::Statement &query, unsigned long long dungeon_id)
-{
-	STACK_TRACE();
-	try
-	{
-		name = query.getColumn("name").getString();
-		flags = query.getColumn("flags").getUInt();
-		sprite = query.getColumn("sprite").getString();
-
-		SQLite::Statement actor_query(*world::save_db(), "SELECT id FROM actors WHERE owner = ? AND x = ? AND y = ?");
-		actor_query.bind(1, static_cast<signed long long>(dungeon_id));
-		actor_query.bind(2, x);
-		actor_query.bind(3, y);
-		while (actor_query.executeStep())
-		{
-			unsigned long long new_id = actor_query.getColumn("id").getInt64();
-			auto new_actor = std::make_shared<Actor>(new_id);
-			new_actor->load(dungeon_id);
-			contained_actors.push_back(new_actor);
-		}
-	}
-	catch (std::exception &e)
-	{
-		guru::halt(e.what());
-	}
-}
-
 // Returns a list of all contained Actors with the ACTOR_FLAG_MONSTER flag.
 vector<unsigned int> Tile::mobs_here() const
 {
 	STACK_TRACE();
 	vector<unsigned int> result;
+	const TileActors &contained_actors = actors();
 	for (unsigned int i = 0; i < contained_actors.size(); i++)
 		if (contained_actors.at(i)->is_monster()) result.push_back(i);
 	return result;
 }
 
-// Check if a neighbour is an identical tile.
-bool Tile::neighbour_identical(int x, int y) const
+// Returns the name of this Tile.
+const string& Tile::name() const
 {
-	STACK_TRACE();
-	if (x < 0 || y < 0 || x >= world::dungeon()->get_width() || y >= world::dungeon()->get_height()) return false;
-	Tile* neighbour = world::dungeon()->tile(x, y);
-	if (neighbour->sprite == sprite) return true;
-	else return false;
+	return owner->tile_palette.at(owner->proto_at(x, y)).name;
 }
 
-// Removes an Actor from this Tile.
-void Tile::remove_actor(unsigned int id)
+// Removes an Actor from this Tile, and returns it.
+shared_ptr<Actor> Tile::remove_actor(unsigned int id)
 {
 	STACK_TRACE();
-	if (contained_actors.size() <= id)
+	auto found = owner->tile_actors.find(index());
+	if (found == owner->tile_actors.end() || found->second.size() <= id)
 	{
 		guru::nonfatal("Out-of-bounds Actor ID in removal request.", GURU_CRITICAL);
-		return;
+		return nullptr;
 	}
-	contained_actors.erase(contained_actors.begin() + id);
+	shared_ptr<Actor> removed = found->second.at(id);
+	found->second.erase(id);
+	if (!found->second.size()) owner->tile_actors.erase(found);
+	owner->actor_grid.remove(removed.get(), x, y);
+	owner->refresh_tile(x, y);
+	return removed;
 }
 
-// Saves this Tile to disk.
-void Tile::save(unsigned long long dungeon_id)
+// Retrieves an owning pointer to a specified Actor, with error checking.
+const shared_ptr<Actor>& TileActors::at(unsigned int id) const
+{
+	if (id >= count) guru::halt("Attempted to retrieve out-of-bounds Actor from tile.");
+	if (id < TILE_ACTORS_INLINE) return inline_actors[id];
+	return overflow[id - TILE_ACTORS_INLINE];
+}
+
+// Removes a specified Actor, keeping the rest in order.
+void TileActors::erase(unsigned int id)
 {
 	STACK_TRACE();
-	try
-	{
-		SQLite::Statement statement(*world::save_db(), "INSERT INTO tiles (dungeon_id, x, y, name, sprite, flags) VALUES (?, ?, ?, ?, ?, ?)");
-		statement.bind(1, static_cast<signed long long>(dungeon_id));
-		statement.bind(2, x);
-		statement.bind(3, y);
-		statement.bind(4, name);
-		statement.bind(5, sprite);
-		statement.bind(6, flags);
-		statement.exec();
-	}
-	catch (std::exception &e)
+	if (id >= count) guru::halt("Attempted to erase out-of-bounds Actor from tile.");
+	for (unsigned int i = id; i + 1 < count; i++)
+		slot(i) = std::move(slot(i + 1));
+	if (--count >= TILE_ACTORS_INLINE) overflow.pop_back();
+	else inline_actors[count].reset();
+}
+
+// Adds an Actor to the end of the list.
+void TileActors::push_back(shared_ptr<Actor> actor)
+{
+	STACK_TRACE();
+	if (count < TILE_ACTORS_INLINE) inline_actors[count] = actor;
+	else overflow.push_back(actor);
+	count++;
+}
+
+// Retrieves the storage for a specified Actor.
+shared_ptr<Actor>& TileActors::slot(unsigned int id)
+{
+	if (id < TILE_ACTORS_INLINE) return inline_actors[id];
+	return overflow[id - TILE_ACTORS_INLINE];
+}
+
+// Creates a new chunk, filled with a single type of tile.
+TileChunk::TileChunk(unsigned short fill_proto, unsigned char fill_flags) : dirty(false), neighbours(), room()
+{
+	STACK_TRACE();
+	std::fill(flags, flags + DUNGEON_CHUNK_AREA, fill_flags);
+	std::fill(proto, proto + DUNGEON_CHUNK_AREA, fill_proto);
+}
+
+// Sets the sprite for this TilePrototype, and resolves the sprite IDs used to render it.
+void TilePrototype::set_sprite(string new_sprite)
+{
+	STACK_TRACE();
+	const unsigned char wall_map[16] = { 5, 4, 2, 15, 2, 15, 2, 15, 4, 4, 11, 14, 11, 12, 11, 13 };
+
+	sprite_id = atom::intern(new_sprite);
+	for (unsigned int i = 0; i < 16; i++)
 	{
-		guru::halt(e.what());
+		// Floor and wall sprites have variants depending on their neighbours, which are resolved here, so rendering never needs to build sprite names.
+		if (new_sprite.size() >= 7 && new_sprite.substr(0, 6) == "FLOOR_") sprite_variants[i] = atom::intern(new_sprite.substr(0, 7) + "_5");
+		else if (new_sprite.size() >= 6 && new_sprite.substr(0, 5) == "WALL_") sprite_variants[i] = atom::intern(new_sprite.substr(0, 6) + "_" + strx::itos(wall_map[i]));
+		else sprite_variants[i] = sprite_id;
 	}
-	for (auto actor : contained_actors)
-		actor->save(dungeon_id);
 }
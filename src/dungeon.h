@@ -2,12 +2,17 @@
 // Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
 
 #pragma once
+#include "actor-grid.h"
+#include "atom.h"
+#include "bitgrid.h"
+#include "cell-set.h"
 #include "duskfall.h"
-#include <set>
+#include "ray-table.h"
+#include "static-data.h"
+#include <unordered_map>
 
 class Actor;	// defined in actor.h
 class AI;		// defined in ai.h
-namespace SQLite { class Statement; }	// defined in SQLiteCpp/SQLiteCpp.h
 
 #define TILE_FLAG_IMPASSIBLE	(1 << 0)
 #define TILE_FLAG_OPAQUE		(1 << 1)
@@ -16,15 +21,140 @@ namespace SQLite { class Statement; }	// defined in SQLiteCpp/SQLiteCpp.h
 #define TILE_FLAG_EXPLORED		(1 << 4)
 #define TILE_FLAG_FLOOR			(1 << 5)
 
+#define DUNGEON_CHUNK_SHIFT		5	// Dungeon tiles are stored in square chunks, 2^DUNGEON_CHUNK_SHIFT tiles across.
+#define DUNGEON_CHUNK_SIZE		(1 << DUNGEON_CHUNK_SHIFT)
+#define DUNGEON_CHUNK_AREA		(DUNGEON_CHUNK_SIZE * DUNGEON_CHUNK_SIZE)
 
+#define TILE_ACTORS_INLINE		2	// The number of Actors a tile can hold before TileActors has to allocate.
+
+#define HERO_LIGHT_RADIUS		100	// The radius of the hero's light, in tiles.
+#define LIGHT_FALLOFF			1.05f	// The falloff curve used for the hero's light and static light sources.
+#define LOS_RAY_RANGE			32		// The range of the precomputed line-of-sight rays; longer lines are traced as needed.
+
+
+class Dungeon;	// defined below
+
+enum class FOVEngine : unsigned char { RECURSIVE, SYMMETRIC };	// The field-of-view engines available to Dungeon::cast_light().
+
+
+// The static properties of a type of Tile, as defined in tiles.json. Dungeons store a small palette of these, rather than a full copy in every cell.
+class TilePrototype
+{
+public:
+			TilePrototype() : flags(0), id(STATIC_ID_NONE), sprite_id(ATOM_NONE), sprite_variants() { }
+	void	set_sprite(string new_sprite);	// Sets the sprite for this TilePrototype, and resolves the sprite IDs used to render it.
+
+	unsigned char	flags;	// The default properties of this tile type.
+	TileID			id;		// The ID of this tile type in the static data, or STATIC_ID_NONE if it didn't come from there (such as tiles loaded from a saved palette).
+	string			name;	// The name of this tile type.
+	unsigned short	sprite_id;	// The interned ID of the sprite representing this tile type.
+	unsigned short	sprite_variants[16];	// The sprite IDs to render for each combination of identical neighbours (see Dungeon::neighbour_mask()).
+};
+
+// A square block of tiles within a Dungeon. Chunks are only allocated when something is written to them; until then, every tile in the chunk is the Dungeon's fill tile.
+// Lighting is kept separately (see Dungeon::light_chunks), so lighting up a tile doesn't allocate a whole chunk for it.
+class TileChunk
+{
+public:
+			TileChunk(unsigned short fill_proto, unsigned char fill_flags);
+
+	bool			dirty;		// Has this chunk changed since it was last saved?
+	unsigned char	flags[DUNGEON_CHUNK_AREA];		// The properties of each tile.
+	unsigned char	neighbours[DUNGEON_CHUNK_AREA];	// A bitmask of identical orthogonal neighbours for each tile, used to pick floor and wall sprites.
+	unsigned short	proto[DUNGEON_CHUNK_AREA];		// An index into the Dungeon's tile palette for each tile.
+	unsigned short	room[DUNGEON_CHUNK_AREA];		// The room or corridor each tile belongs to, or 0 if it isn't part of either.
+};
+
+// A doorway leading out of a DungeonRoom, and the room on the other side of it.
+class RoomDoorway
+{
+public:
+			RoomDoorway(unsigned short new_x, unsigned short new_y, unsigned short new_target) : target(new_target), x(new_x), y(new_y) { }
+
+	unsigned short	target;	// The room ID this doorway leads into.
+	unsigned short	x, y;	// The tile on this side of the doorway.
+};
+
+// A room or stretch of corridor within a Dungeon. Along with their doorways, these make a coarse graph of the level, which can be searched without flooding the whole map.
+class DungeonRoom
+{
+public:
+			DungeonRoom() : corridor(false), h(0), w(0), x(0), y(0) { }
+
+	bool			corridor;	// Is this a stretch of corridor, rather than a room?
+	vector<RoomDoorway>	doorways;	// The doorways linking this room to its neighbours.
+	CellSet			free_cells;	// The tiles in this room which can be walked on, and have nothing in them.
+	unsigned short	h, w, x, y;	// The bounding box of this room.
+};
+
+// A static light source within a Dungeon. Its light map is worked out once, and only recalculated when something within its radius changes opacity.
+class LightSource
+{
+public:
+			LightSource(unsigned int new_id, unsigned short new_x, unsigned short new_y, unsigned short new_radius) : dirty(true), id(new_id), radius(new_radius), x(new_x), y(new_y) { }
+
+	bool			dirty;	// Does the light map need recalculating?
+	unsigned int	id;		// The ID of this light source within its Dungeon.
+	vector<std::pair<unsigned int, unsigned char>>	light_map;	// The tiles lit by this light source, and how brightly.
+	unsigned short	radius;	// How far this light reaches.
+	vector<unsigned int>	walls;	// The walls within reach of this light source, which take their light from the tiles around them.
+	unsigned short	x, y;	// The position of this light source.
+};
+
+// A single query for Dungeon::los_batch(), checking the line between two tiles.
+class LOSQuery
+{
+public:
+			LOSQuery(unsigned short new_x1, unsigned short new_y1, unsigned short new_x2, unsigned short new_y2) : x1(new_x1), y1(new_y1), x2(new_x2), y2(new_y2) { }
+
+	unsigned short	x1, y1, x2, y2;	// The two ends of the line. As with los_check(), the line is traced from x1,y1 to x2,y2.
+};
+
+// The Actors within a single tile. Most tiles hold at most one or two Actors, so these are stored inline, only spilling over onto the heap when a tile gets crowded.
+// Iterating over a TileActors gives plain Actor pointers, so it doesn't need to touch any reference counts; use at() when an owning pointer is needed.
+class TileActors
+{
+public:
+	class iterator
+	{
+	public:
+					iterator(const TileActors *new_owner, unsigned int new_pos) : owner(new_owner), pos(new_pos) { }
+		Actor*		operator*() const { return owner->get(pos); }
+		iterator&	operator++() { pos++; return *this; }
+		bool		operator!=(const iterator &other) const { return pos != other.pos; }
+
+	private:
+		const TileActors	*owner;	// The TileActors being iterated over.
+		unsigned int		pos;	// The current position within the TileActors.
+	};
+
+				TileActors() : count(0) { }
+	const shared_ptr<Actor>&	at(unsigned int id) const;	// Retrieves an owning pointer to a specified Actor, with error checking.
+	iterator	begin() const { return iterator(this, 0); }	// Iterator to the first Actor.
+	iterator	end() const { return iterator(this, count); }	// Iterator past the last Actor.
+	void		erase(unsigned int id);	// Removes a specified Actor, keeping the rest in order.
+	Actor*		get(unsigned int id) const { return (id < TILE_ACTORS_INLINE ? inline_actors[id] : overflow[id - TILE_ACTORS_INLINE]).get(); }	// Retrieves a specified Actor, without error checking.
+	void		push_back(shared_ptr<Actor> actor);	// Adds an Actor to the end of the list.
+	unsigned int	size() const { return count; }	// The number of Actors held.
+
+private:
+	unsigned int		count;	// The number of Actors held.
+	shared_ptr<Actor>	inline_actors[TILE_ACTORS_INLINE];	// The first few Actors, stored inline.
+	vector<shared_ptr<Actor>>	overflow;	// Any further Actors.
+
+	shared_ptr<Actor>&	slot(unsigned int id);	// Retrieves the storage for a specified Actor.
+};
+
+// A lightweight view of a single cell in a Dungeon. The actual data lives in the Dungeon's tile chunks; a Tile is just a way of looking at it.
 class Tile
 {
 public:
-			Tile() : flags(0), x(0), y(0) { }
-	vector<shared_ptr<Actor>>*	actors() { return &contained_actors; }	// Return a pointer to the contained_actors vector.
+			Tile(Dungeon *new_owner, unsigned short new_x, unsigned short new_y) : x(new_x), y(new_y), owner(new_owner) { }
+	const TileActors&	actors() const;	// Read-only access to the Actors in this Tile.
 	void	add_actor(shared_ptr<Actor> actor);	// Adds an Actor to this Tile.
 	bool	contains_los_blocker() const;	// Checks if this Tile contains an Actor that blocks line-of-sight.
-	string	get_sprite() const;		// Returns the sprite name for rendering this tile.
+	unsigned char	flags() const;	// Returns the flags for this Tile.
+	unsigned short	get_sprite() const;	// Returns the sprite ID for rendering this tile.
 	unsigned int	has_door() const;	// Checks if a door is present here, and returns the Actor vector ID if so.
 	bool	is_destroyable_wall() const;	// Is this Tile a wall that can be destroyed?
 	bool	is_explored() const;	// Has this Tile been explored?
@@ -34,66 +164,137 @@ public:
 	bool	is_permawall() const;	// Is this Tile a wall that can never be destroyed under any circumstances?
 	bool	is_wall() const;		// Is this Tile a wall of some kind?
 	vector<unsigned int>	items_here() const;	// Returns a list of all contained Actors with the ACTOR_FLAG_ITEM flag.
-	void	load(SQLite::Statement &query, unsigned long long dungeon_id);	// Loads this Tile from disk.
 	vector<unsigned int>	mobs_here() const;	// Returns a list of all contained Actors with the ACTOR_FLAG_MONSTER flag.
-	void	remove_actor(unsigned int id);		// Removes an Actor from this Tile.
-	void	save(unsigned long long dungeon_id);	// Saves this Tile to disk.
-	void	set_sprite(string new_sprite) { sprite = new_sprite; }	// Sets the sprite for this Tile.
+	const string&	name() const;	// Returns the name of this Tile.
+	shared_ptr<Actor>	remove_actor(unsigned int id);	// Removes an Actor from this Tile, and returns it.
 
-	unsigned char	flags;	// Various properties of this tile.
-	string			name;	// The name of this Tile.
 	unsigned short	x, y;	// The X,Y coordinates for this Tile.
 
 private:
-	string	check_neighbours(int x, int y, bool wall) const;	// Checks nearby tiles to modify floor and wall sprites.
-	bool	neighbour_identical(int x, int y) const;			// Check if a neighbour is an identical tile.
+	unsigned int	index() const;	// The index of this Tile within the Dungeon, used as a key for its Actors.
 
-	vector<shared_ptr<Actor>>	contained_actors;	// Actors who are present within this Tile.
-	string	sprite;			// The sprite representing this tile. Private, since we should be using get_sprite() to access it.
+	Dungeon	*owner;	// The Dungeon this Tile belongs to.
 };
 
 class Dungeon
 {
 public:
-			Dungeon(unsigned short new_id, unsigned short new_width = 0, unsigned short new_height = 0);
-			~Dungeon();
+			Dungeon(unsigned long long new_id, unsigned short new_width = 0, unsigned short new_height = 0);
 	void	add_active_ai(shared_ptr<AI> new_ai);	// Adds an Actor's AI to the active AI list.
+	unsigned int	add_light(unsigned short x, unsigned short y, unsigned short radius);	// Adds a static light source, and returns its ID.
+	void	assign_ids();	// Gives a unique ID to anything on this level which was created without one, such as when the level was generated in the background.
+	bool	blocks_light(unsigned short x, unsigned short y) const { return opaque_bits.get(x, y); }	// Checks if a tile is opaque, or contains an Actor that blocks line-of-sight.
+	bool	blocks_movement(unsigned short x, unsigned short y) const { return impassible_bits.get(x, y) || blocker_bits.get(x, y); }	// Checks if a tile is impassible, or contains an Actor that blocks movement.
+	void	fill(const TilePrototype &new_tile);	// Resets every tile in the dungeon to the same type, without allocating any chunks.
+	void	freeze();	// Drops the lighting, bitboards and free cell indexes, which can all be worked out again later, while this level isn't the current one.
 	void	generate();	// Generates a new dungeon level.
+	void	generate(unsigned long long seed);	// Generates a new dungeon level from a specified seed. The same seed and level size will always give the same layout.
 	void	generate_type_a();	// Generates a type A dungeon level.
+	bool	hero_visible(unsigned short x, unsigned short y) const;	// Checks if a tile is within the hero's field of view, falling back on los_check() if the lighting is out of date.
+	const ActorGrid&	get_actor_grid() const { return actor_grid; }	// Read-only access to the spatial index of Actors on this level.
 	unsigned short	get_height() const { return height; }	// Read-only access to the dungeon height.
-	unsigned int	get_id() const { return id; }		// Read-only access to the dungeon ID.
+	unsigned int	get_hero_fov_generation() const { return hero_fov_generation; }	// Changes whenever the hero's field of view is recalculated, so anything caching visibility knows to check again.
+	unsigned long long	get_id() const { return id; }	// Read-only access to the dungeon ID.
+	const LightSource&	get_light(unsigned int light_id) const;	// Read-only access to a specified static light source.
+	const DungeonRoom&	get_room(unsigned short room) const;	// Read-only access to a specified room.
+	unsigned short	get_room_count() const { return rooms.size(); }	// The number of room IDs in use, including the unused room ID 0.
 	unsigned short	get_width() const { return width; }	// Read-only access to the dungeon width.
+	bool	is_dead_end(unsigned short x, unsigned short y) const;			// Check to see if this tile is a dead-end.
+	unsigned long long	layout_hash() const;	// Hashes the tiles and Actors of this level, so two levels can be checked for being identical.
 	void	load();		// Loadds this dungeon from disk.
+	void	los_batch(const vector<LOSQuery> &queries, vector<bool> &results) const;	// Checks line-of-sight for a batch of queries at once, using precomputed rays.
 	bool	los_check(unsigned short x1, unsigned short y1, unsigned short x2 = USHRT_MAX, unsigned short y2 = USHRT_MAX) const;	// Line-of-sight check. See dungeon.cpp for full details!
 	void	map_view(bool see_all = false);	// View the dungeon map in its entirety.
 	void	random_start_position(unsigned short &x, unsigned short &y) const;	// Picks a viable random starting location.
-	void	recalc_lighting();	// Clears the lighting array and recalculates all light sources.
+	void	recalc_lighting();	// Recalculates the lighting, only redoing the parts of it which could have changed.
+	void	remove_light(unsigned int light_id);	// Removes a static light source.
+	void	refresh_tile(unsigned short x, unsigned short y);	// Updates the bitboards and cell indices for a tile, after its flags or Actors have changed.
 	void	render(bool see_all = false);	// Renders the dungeon on the screen.
+	unsigned short	room_at(unsigned short x, unsigned short y) const;	// Returns the room ID of a specified tile, or 0 if it isn't part of any room or corridor.
 	void	save();		// Saves this dungeon to disk.
-	void	set_tile(unsigned short x, unsigned short y, Tile &new_tile);	// Sets a specified tile, with error checking.
+	void	set_tile(unsigned short x, unsigned short y, const TilePrototype &new_tile);	// Sets a specified tile, with error checking.
+	void	thaw();		// Rebuilds everything dropped by freeze(), ready for this level to become the current one again.
 	void	tick_ai();	// Runs any active AI in this Dungeon.
-	Tile*	tile(unsigned short x, unsigned short y) const;	// Retrieves a specified tile pointer.
+	Tile	tile(unsigned short x, unsigned short y) const;	// Retrieves a view of a specified tile.
+
+	static FOVEngine	fov_engine;	// The field-of-view engine used for lighting; this can be switched at any time, to compare them.
+	static unsigned short	light_cull_margin;	// How many tiles beyond the edge of the screen the hero's light reaches, when culling.
+	static bool			light_culling;	// Only calculate the hero's light for the part of the map on the screen, plus a margin around it.
 
 private:
+	friend class Tile;
+
 	std::vector<shared_ptr<AI>>	active_ai;	// Active AI on Actors that needs to be triggered each turn.
-	std::set<std::pair<unsigned short, unsigned short>> dynamic_light_temp, dynamic_light_temp_walls;	// Temporary data used by the dynamic lighting system.
+	ActorGrid			actor_grid;		// A spatial index of all the Actors on this level.
+	BitGrid				blocker_bits;	// Tiles which contain an Actor that blocks movement.
+	unsigned short		chunk_cols;		// The width of the dungeon, in chunks.
+	vector<shared_ptr<TileChunk>>	chunks;	// The tile chunks making up this dungeon, or nullptr for chunks which have not been allocated yet.
+	unsigned int		dynamic_light_epoch;	// The current pass of the dynamic lighting system; tiles stamped with this have already been lit during this pass.
+	vector<vector<unsigned int>>	dynamic_light_stamp;	// The lighting pass in which each tile was last lit, in chunks matching the tile chunks. Chunks which haven't been reached by any light aren't allocated.
+	vector<unsigned int>	dynamic_light_temp;	// The tiles lit during the current lighting pass.
+	unsigned char		fill_flags;		// The flags of the fill tile, used for any tile in an unallocated chunk.
+	unsigned short		fill_proto;		// The palette index of the fill tile, used for any tile in an unallocated chunk.
+	CellSet				free_cells;		// Tiles which can be walked on, and have nothing in them.
+	bool				frozen;			// Has this level been frozen? See freeze().
 	unsigned short		height;			// The height of the dungeon (Y).
+	BitGrid				hero_fov_bits;	// Tiles within the hero's field of view, as of the last lighting calculation.
+	unsigned int		hero_fov_generation;	// Incremented every time the hero's field of view is recalculated.
+	vector<unsigned int>	hero_light_cells[8];	// The tiles lit by the hero in each shadowcasting octant, so the octants can be recalculated separately.
 	unsigned long long	id;				// The unique ID of this Dungeon.
-	unsigned char		*lighting;		// An array of 8-bit integers defining the light level or visibility of tiles.
+	BitGrid				impassible_bits;	// Tiles which cannot be walked through.
+	vector<std::pair<unsigned int, unsigned char>>	light_blend;	// The light added to each tile by the static light sources, so it can be taken off again.
+	vector<vector<unsigned char>>	light_chunks;	// The light level or visibility of each tile, in chunks matching the tile chunks. Chunks which have never been lit aren't allocated.
+	static vector<unsigned char>	light_falloff;	// The brightness of light at each squared distance from its source, up to the hero's light radius.
+	unsigned short		light_clip_x1, light_clip_y1, light_clip_x2, light_clip_y2;	// The area the hero's light was last calculated within, inclusive.
+	bool				light_clipping;	// Is the hero's light being clipped to the area above?
+	vector<unsigned int>	light_dirty;	// Tiles which have changed opacity since the lighting was last calculated.
+	unsigned int		light_id_next;	// The ID to give the next static light source.
+	unsigned short		light_origin_x, light_origin_y;	// Where the hero was when the lighting was last calculated, or USHRT_MAX if it needs recalculating in full.
+	vector<LightSource>	lights;			// The static light sources on this level.
+	bool				lights_changed;	// Have any static light sources been added or removed since the lighting was last calculated?
+	static RayTable		los_rays;		// Precomputed rays used by los_batch().
+	BitGrid				opaque_bits;	// Tiles which block light, either because of the tile itself or an Actor within it.
 	unsigned int		*region;		// The region the current tile belongs to (used during dungeon generation).
-	Tile				*tiles;			// An array of Tiles which make up this area.
+	vector<DungeonRoom>	rooms;			// The rooms and corridors in this Dungeon, indexed by room ID. Entry 0 is unused, as room ID 0 means a tile isn't in any room.
+	std::unordered_map<unsigned int, TileActors>	tile_actors;	// Sparse index of the Actors within each tile, keyed by tile index.
+	vector<TilePrototype>	tile_palette;	// The types of tile used in this Dungeon, referred to by the tile chunks.
+	vector<unsigned short>	tile_palette_lookup;	// The palette index for each TileID which has been added to the palette, or USHRT_MAX for those which haven't.
+	CellSet				walkable_cells;	// Tiles which can be walked on.
 	unsigned short		width;			// The width of the dungeon (X).
 
+	void	allocate_chunks();	// Sets up the chunk index, bitboards and Actor grid, once the width and height are known.
+	void	blend_lights();		// Adds the light from every static light source onto the tiles the hero can see.
+	void	build_room_graph(const vector<std::pair<unsigned short, unsigned short>> &connectors);	// Assigns room IDs to the corridors, and links all the rooms and corridors together with doorways.
 	void	carve_room(unsigned short x, unsigned short y, unsigned short w, unsigned short h, unsigned int new_region);	// Carves out a square room.
 	void	cast_light(unsigned int x, unsigned int y, unsigned int radius, unsigned int row, float start_slope, float end_slope, unsigned int xx, unsigned int xy, unsigned int yx, unsigned int yy,  bool always_visible);
-	unsigned char	diminish_light(float distance, float falloff) const;	// Dims a specified light source.
+	void	cast_light_symmetric(unsigned int x, unsigned int y, unsigned int radius, unsigned int row, unsigned int start_num, unsigned int start_den, unsigned int end_num, unsigned int end_den, int xx, int xy, int yx, int yy,
+		bool always_visible);	// Symmetric shadowcasting engine, using integer slopes.
+	TileChunk*	chunk(unsigned short x, unsigned short y) const;	// Returns the chunk containing a specified tile, or nullptr if it has not been allocated.
+	unsigned int	chunk_index(unsigned short x, unsigned short y) const { return (x >> DUNGEON_CHUNK_SHIFT) + (y >> DUNGEON_CHUNK_SHIFT) * chunk_cols; }	// The index of the chunk containing a specified tile.
+	static unsigned char	diminish_light(float distance, float falloff);	// Dims a specified light source.
+	static unsigned char	diminish_light_sq(unsigned int dist_sq);	// Dims a light source at a given squared distance, using the falloff lookup table.
 	void	explore(unsigned short x, unsigned short y);					// Marks a given tile as explored.
-	std::pair<unsigned short, unsigned short>	find_empty_tile(unsigned short x, unsigned short y, unsigned short w, unsigned short h) const;	// Attempts to find an empty tile within the specified space.
-	bool	is_dead_end(unsigned short x, unsigned short y) const;			// Check to see if this tile is a dead-end.
-	void	recalc_light_source(unsigned short x, unsigned short y, unsigned short radius, bool always_visible = false);	// Recalculates a specific light source.
-	void	region_floodfill(unsigned short x, unsigned short y, unsigned int new_region);		// Flood-fills a specified area with a new region ID.
+	std::pair<unsigned short, unsigned short>	find_empty_tile(unsigned short room) const;	// Picks a random empty tile within the specified room.
+	unsigned char	flags_at(unsigned short x, unsigned short y) const;	// Returns the flags of a specified tile.
+	unsigned char	light_at(unsigned short x, unsigned short y) const;	// Returns the light level of a specified tile.
+	unsigned int	light_clip_depth(unsigned int x, unsigned int y, int xy, int yy) const;	// Returns how far a shadowcasting octant can go before leaving the lighting clip area.
+	unsigned short	local_index(unsigned short x, unsigned short y) const { return (x & (DUNGEON_CHUNK_SIZE - 1)) + ((y & (DUNGEON_CHUNK_SIZE - 1)) << DUNGEON_CHUNK_SHIFT); }	// The index of a tile within its chunk.
+	bool	neighbour_identical(unsigned short proto, int x, int y) const;	// Check if a neighbour is an identical tile.
+	unsigned char	neighbour_mask(unsigned short x, unsigned short y) const;	// Checks nearby tiles to modify floor and wall sprites.
+	void	new_light_pass();	// Starts a new pass of the dynamic lighting system, forgetting which tiles were lit by the last one.
+	unsigned short	palette_id(const TilePrototype &proto);	// Finds or adds a TilePrototype in this Dungeon's palette.
+	unsigned short	proto_at(unsigned short x, unsigned short y) const;	// Returns the palette index of a specified tile.
+	void	recalc_chunk_masks(unsigned int chunk_id);	// Recalculates the neighbour masks for every tile in a chunk.
+	void	recalc_hero_octant(unsigned int octant);	// Recalculates the hero's light within a single shadowcasting octant.
+	void	recalc_light_map(LightSource &light);	// Recalculates the light map for a static light source.
+	void	set_light(unsigned short x, unsigned short y, unsigned char light);	// Sets the light level of a specified tile.
+	void	set_room(unsigned short x, unsigned short y, unsigned short room);	// Sets the room ID of a specified tile.
+	bool	stamp_light(unsigned short x, unsigned short y);	// Marks a tile as reached by the current lighting pass, returning false if it already was.
+	TileChunk*	touch_chunk(unsigned short x, unsigned short y);	// Returns the chunk containing a specified tile, allocating it if needed.
+	void	unblend_lights();	// Takes the light from the static light sources off again.
 	bool	touches_two_regions(unsigned short x, unsigned short y) const;	// Checks if this tile touches a different region.
+	void	update_neighbour_masks(unsigned short x, unsigned short y);		// Updates the neighbour masks around a tile which has changed.
 	int		viable_doorway(unsigned short x, unsigned short y) const;		// Checks if this tile is a viable doorway.
 	bool	viable_maze_position(unsigned short x, unsigned short y) const;	// Checks if this tile is a viable position to build a maze corridor.
-	bool	viable_room_position(unsigned short x, unsigned short y, unsigned short w, unsigned short h) const;	// Checks if this is a viable position to place a new room.
+	bool	view_bounds(unsigned short &x1, unsigned short &y1, unsigned short &x2, unsigned short &y2) const;	// Works out which part of the map is on the screen.
 };
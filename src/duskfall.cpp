@@ -1,12 +1,14 @@
 // duskfall.cpp -- Program main entry point. Not much to see here, but this is where it starts.
 // Copyright (c) 2016-2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
 
+#include "benchmark.h"
 #include "dungeon.h"
 #include "duskfall.h"
 #include "guru.h"
 #include "iocore.h"
 #include "mathx.h"
 #include "prefs.h"
+#include "self-test.h"
 #include "static-data.h"
 #include "title.h"
 #include "wiki.h"
@@ -19,10 +21,41 @@ int main(int argc, char* argv[])
 
 	guru::open_syslog();
 	mathx::init();
+
+	// Headless dungeon generation benchmark: duskfall -genbench [levels at each size] [first seed]
+	if (parameters.size() >= 2 && parameters.at(1) == "-genbench")
+	{
+		unsigned int levels = BENCHMARK_DEFAULT_LEVELS;
+		unsigned long long seed = BENCHMARK_DEFAULT_SEED;
+		try
+		{
+			if (parameters.size() >= 3) levels = std::stoul(parameters.at(2));
+			if (parameters.size() >= 4) seed = std::stoull(parameters.at(3));
+		}
+		catch (std::exception &e)
+		{
+			guru::halt("Invalid parameters for -genbench: " + string(e.what()));
+		}
+		data::init();
+		benchmark::generation(levels, seed);
+		guru::close_syslog();
+		return 0;
+	}
+
 	prefs::init();
 	iocore::init();
 	data::init();
 	wiki::init();
+
+	// Self-tests: duskfall -selftest
+	if (parameters.size() >= 2 && parameters.at(1) == "-selftest")
+	{
+		const bool passed = selftest::run();
+		iocore::exit_functions();
+		guru::close_syslog();
+		return (passed ? 0 : 1);
+	}
+
 	guru::log("Everything looks good! Starting the game!", GURU_INFO);
 	title::title_screen();
 	iocore::exit_functions();
@@ -105,10 +105,22 @@ void purge()
 			dungeon_statement.bind(1, static_cast<signed long long>(id));
 			dungeon_statement.exec();
 
-			// Delete all tiles that match this dungeon. This is a lot of deletions, but should be pretty fast as it's a single batch.
-			SQLite::Statement tiles_statement(*world::save_db(), "DELETE FROM tiles WHERE dungeon_id = ?");
-			tiles_statement.bind(1, static_cast<signed long long>(id));
-			tiles_statement.exec();
+			// Delete all tile chunks, palette entries, rooms, doorways and light sources that match this dungeon.
+			SQLite::Statement chunks_statement(*world::save_db(), "DELETE FROM chunks WHERE dungeon_id = ?");
+			chunks_statement.bind(1, static_cast<signed long long>(id));
+			chunks_statement.exec();
+			SQLite::Statement palette_statement(*world::save_db(), "DELETE FROM palette WHERE dungeon_id = ?");
+			palette_statement.bind(1, static_cast<signed long long>(id));
+			palette_statement.exec();
+			SQLite::Statement rooms_statement(*world::save_db(), "DELETE FROM rooms WHERE dungeon_id = ?");
+			rooms_statement.bind(1, static_cast<signed long long>(id));
+			rooms_statement.exec();
+			SQLite::Statement doorways_statement(*world::save_db(), "DELETE FROM doorways WHERE dungeon_id = ?");
+			doorways_statement.bind(1, static_cast<signed long long>(id));
+			doorways_statement.exec();
+			SQLite::Statement lights_statement(*world::save_db(), "DELETE FROM lights WHERE dungeon_id = ?");
+			lights_statement.bind(1, static_cast<signed long long>(id));
+			lights_statement.exec();
 
 			// Wipe out all the Actors in this Dungeon. We have to be sure to add Inventories, Attackers and Defendeers too -- destroy_actor() will handle that part.
 			SQLite::Statement actors_query(*world::save_db(), "SELECT id FROM actors WHERE owner = ?");
@@ -1,6 +1,7 @@
 // hero.cpp -- The Hero class, where the player data and other important stuff about the world is stored.
 // Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
 
+#include "atom.h"
 #include "attacker.h"
 #include "controls.h"
 #include "defender.h"
@@ -21,7 +22,7 @@
 Hero::Hero(unsigned long long new_id) : Actor(new_id), camera_off_x(0), camera_off_y(0), difficulty(1), played(0), style(1)
 {
 	STACK_TRACE();
-	sprite = "PLAYER";
+	sprite = atom::intern("PLAYER");
 	flags |= ACTOR_FLAG_ANIMATED;
 	ai = std::make_shared<Controls>(this, world::unique_id());
 	inventory = std::make_shared<Inventory>(world::unique_id());
@@ -138,15 +139,15 @@ void Hero::save(unsigned long long owner_id)
 void Hero::tile_react()
 {
 	STACK_TRACE();
-	auto tile = world::dungeon()->tile(x, y);
+	const Tile tile = world::dungeon()->tile(x, y);
 	vector<shared_ptr<Actor>> items_here;
-	for (unsigned int id : tile->items_here())
-		items_here.push_back(tile->actors()->at(id));
+	for (unsigned int id : tile.items_here())
+		items_here.push_back(tile.actors().at(id));
 	if (items_here.size())
 	{
 		vector<string> item_names;
 		for (auto item : items_here)
-			item_names.push_back(item->name);
+			item_names.push_back(atom::name(item->name));
 		message::msg("You see " + strx::comma_list(item_names, true) + " here.");
 	}
 }
@@ -1,6 +1,7 @@
 // iocore.cpp -- The render core, handling display and user interaction, as well as program initialization, shutdown and cleanup functionality.
 // Copyright (c) 2016-2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
 
+#include "atom.h"
 #include "filex.h"
 #include "guru.h"
 #include "iocore.h"
@@ -135,7 +136,7 @@ unsigned char	surface_scale = 0;		// The surface scale modifier.
 SDL_Surface		*temp_surface = nullptr;	// Temporary surface used for blitting glyphs.
 SDL_Surface		**tileset = nullptr;	// The currently-loaded tileset.
 unsigned int	tileset_file_count = 0;	// How many files are loaded for this tileset?
-std::unordered_map<string, std::pair<unsigned int, unsigned int>>	tileset_map;	// The definitions map for the currently-loaded tileset.
+vector<std::pair<unsigned int, unsigned int>>	tileset_map;	// The definitions map for the currently-loaded tileset, indexed by sprite atom ID.
 unsigned int	tileset_pixel_size = 0;	// The size of the tiles in pixels (e.g. 16 = 16x16 tiles)
 bool			tileset_supports_alpha = false;		// Set to true if the currently-loaded tileset supports layering multiple sprites with alpha blending.
 bool			tileset_supports_animation = false;	// Set to true is the currently-loaded tileset supports two-frame animation.
@@ -1043,7 +1044,9 @@ void load_tileset(string dir)
 		vector<string> def_parsed = strx::string_explode(def_unparsed, ":");
 		if (def_parsed.size() != 2) guru::halt("Formatting error in " + dir + " tileset: " + def_id);
 		std::pair<unsigned int, unsigned int> new_pair = std::pair<unsigned int, unsigned int>(atoi(def_parsed.at(0).c_str()), atoi(def_parsed.at(1).c_str()));
-		tileset_map.insert(std::pair<string, std::pair<unsigned int, unsigned int>>(def_id, new_pair));
+		const unsigned short def_atom = atom::intern(def_id);
+		if (tileset_map.size() <= def_atom) tileset_map.resize(def_atom + 1, std::pair<unsigned int, unsigned int>(UINT_MAX, 0));
+		tileset_map.at(def_atom) = new_pair;
 	}
 	if (ntsc_filter)
 	{
@@ -1299,8 +1302,8 @@ void print_at(char letter, int x, int y, unsigned char r, unsigned char g, unsig
 	print_at(static_cast<Glyph>(letter), x, y, r, g, b, print_flags);
 }
 
-// Renders a tile from the active tileset on the screen at the specified location.
-void print_tile(string tile, int x, int y, unsigned char brightness, bool animated)
+// Renders a tile (by sprite atom ID) from the active tileset on the screen at the specified location.
+void print_tile(unsigned short tile, int x, int y, unsigned char brightness, bool animated)
 {
 	STACK_TRACE();
 	if (!brightness || !tileset_supports_alpha)
@@ -1311,19 +1314,19 @@ void print_tile(string tile, int x, int y, unsigned char brightness, bool animat
 	if (!tileset_supports_animation || !prefs::animation) animated = false;
 
 	// Sanity checks to ensure the tilesheet data is valid and we're not trying to load something that doesn't exist.
-	auto found = tileset_map.find(tile);
-	if (found == tileset_map.end())
+	static const unsigned short error_tile = atom::intern("ERROR");
+	if (tile >= tileset_map.size() || tileset_map[tile].first == UINT_MAX)
 	{
-		guru::nonfatal("Missing tile: " + tile, GURU_ERROR);
-		if (tile != "ERROR") print_tile("ERROR", x, y, brightness);
+		guru::nonfatal("Missing tile: " + atom::name(tile), GURU_ERROR);
+		if (tile != error_tile) print_tile(error_tile, x, y, brightness);
 		else rect(x, y, tileset_pixel_size, tileset_pixel_size, Colour::ERROR_COLOUR);
 		return;
 	}
-	unsigned int sheet = found->second.first;
-	unsigned int tile_pos = found->second.second;
+	unsigned int sheet = tileset_map[tile].first;
+	unsigned int tile_pos = tileset_map[tile].second;
 	if (sheet >= tileset_file_count || tile_pos * tileset_pixel_size > static_cast<unsigned int>(tileset[sheet]->w * tileset[sheet]->h))
 	{
-		guru::nonfatal("Invalid tilesheet definition: " + tile, GURU_ERROR);
+		guru::nonfatal("Invalid tilesheet definition: " + atom::name(tile), GURU_ERROR);
 		rect(x, y, tileset_pixel_size, tileset_pixel_size, Colour::ERROR_COLOUR);
 		return;
 	}
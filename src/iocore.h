@@ -128,7 +128,7 @@ void	print_at(Glyph letter, int x, int y, Colour colour, unsigned int print_flag
 void	print_at(char letter, int x, int y, Colour colour, unsigned int print_flags = 0);	// As above, but with a char instead of a glyph.
 void	print_at(Glyph letter, int x, int y, unsigned char r, unsigned char g, unsigned char b, unsigned int print_flags = 0);	// Prints a character at a given coordinate on the screen, in RGB colours.
 void	print_at(char letter, int x, int y, unsigned char r, unsigned char g, unsigned char b, unsigned int print_flags = 0);	// As above, but with a char instead of a glyph.
-void	print_tile(string tile, int x, int y, unsigned char brightness = 255, bool animted = false);	// Renders a tile from the active tileset on the screen at the specified location.
+void	print_tile(unsigned short tile, int x, int y, unsigned char brightness = 255, bool animted = false);	// Renders a tile (by sprite atom ID) from the active tileset on the screen at the specified location.
 void	put_pixel(s_rgb rgb, int x, int y);	// Writes a pixel to the main surface.
 void	rect(int x, int y, int w, int h, Colour colour);		// Draws a coloured rectangle
 void	rect_fine(int x, int y, int w, int h, Colour colour);	// Draws a rectangle at very specific coords.
@@ -0,0 +1,202 @@
+// levels.cpp -- The level manager, which keeps the most recently visited dungeon levels in memory, and writes the rest out to the save file.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#include "dungeon.h"
+#include "guru.h"
+#include "levels.h"
+#include "mathx.h"
+#include "world.h"
+
+#include "SQLiteCpp/SQLiteCpp.h"
+
+#include <cstdlib>
+#include <future>
+#include <list>
+#include <map>
+
+
+namespace levels
+{
+
+unsigned short	current_depth = 0;	// The depth of the current dungeon level.
+bool			exit_handler = false;	// Has wait_for_pending() been set to run when the program exits?
+std::map<unsigned short, unsigned long long>	level_ids;	// The dungeon ID of every level which has been generated so far, keyed by depth.
+std::map<unsigned short, std::future<shared_ptr<Dungeon>>>	pending;	// Dungeon levels being generated in the background, keyed by depth.
+std::list<shared_ptr<Dungeon>>	resident;	// The dungeon levels currently held in memory, most recently used first.
+
+void	evict();	// Writes the least recently used dungeon level to disk, and drops it from memory.
+void	save_index();	// Saves the level index to disk.
+void	wait_for_pending();	// Waits for any dungeon levels being generated in the background to finish.
+
+
+// The depth of the current dungeon level.
+unsigned short current()
+{
+	return current_depth;
+}
+
+// Makes the dungeon level at the specified depth current, loading or generating it as needed.
+shared_ptr<Dungeon> enter(unsigned short depth)
+{
+	STACK_TRACE();
+	current_depth = depth;
+	shared_ptr<Dungeon> level = nullptr;
+	auto found = level_ids.find(depth);
+	if (found == level_ids.end())
+	{
+		// If this level was being generated in the background, take it over; this waits for the generator to finish, if it hasn't already.
+		auto pregen = pending.find(depth);
+		if (pregen != pending.end())
+		{
+			level = pregen->second.get();
+			pending.erase(pregen);
+			level->assign_ids();
+		}
+		else
+		{
+			level = std::make_shared<Dungeon>(world::unique_id(), 100, 100);
+			level->generate();
+		}
+		level_ids.insert(std::pair<unsigned short, unsigned long long>(depth, level->get_id()));
+	}
+	else
+	{
+		// If the level is still in memory, it just needs to be moved to the front of the queue.
+		for (auto it = resident.begin(); it != resident.end(); ++it)
+		{
+			if ((*it)->get_id() != found->second) continue;
+			level = *it;
+			resident.erase(it);
+			break;
+		}
+		if (!level)
+		{
+			level = std::make_shared<Dungeon>(found->second);
+			level->load();
+		}
+	}
+
+	// Only the current level needs its lighting, bitboards and free cell indexes, so the one being left behind drops them until it's entered again.
+	if (resident.size()) resident.front()->freeze();
+	level->thaw();
+	resident.push_front(level);
+	while (resident.size() > LEVEL_CACHE_SIZE) evict();
+	return level;
+}
+
+// Writes the least recently used dungeon level to disk, and drops it from memory.
+// Dungeons only write out the chunks which have changed since they were last saved, so this is usually quick.
+void evict()
+{
+	STACK_TRACE();
+	shared_ptr<Dungeon> level = resident.back();
+	resident.pop_back();
+	try
+	{
+		SQLite::Transaction transaction(*world::save_db());
+		level->save();
+		save_index();
+		transaction.commit();
+	}
+	catch (std::exception &e)
+	{
+		guru::halt(e.what());
+	}
+}
+
+// Loads the level index from disk.
+void load()
+{
+	STACK_TRACE();
+	reset();
+	try
+	{
+		SQLite::Statement query(*world::save_db(), "SELECT * FROM levels");
+		while (query.executeStep())
+		{
+			const unsigned short depth = query.getColumn("depth").getUInt();
+			level_ids.insert(std::pair<unsigned short, unsigned long long>(depth, static_cast<unsigned long long>(query.getColumn("dungeon_id").getInt64())));
+			if (query.getColumn("current").getUInt()) current_depth = depth;
+		}
+	}
+	catch (std::exception &e)
+	{
+		guru::halt(e.what());
+	}
+	if (level_ids.find(current_depth) == level_ids.end()) guru::halt("Could not find the current dungeon level in the save file!");
+}
+
+// Starts generating the dungeon level at the specified depth in the background, if it doesn't already exist.
+// The generator gets its own pseudorandom number generator, seeded from the main one, and doesn't touch the save file; the level is handed over when enter() is called for its depth.
+void pregenerate(unsigned short depth)
+{
+	STACK_TRACE();
+	if (level_ids.find(depth) != level_ids.end() || pending.find(depth) != pending.end()) return;
+	const unsigned long long seed = mathx::rnd(UINT_MAX);
+
+	// If the game quits while a level is still being generated, the generator has to finish before the static data it's using is destroyed.
+	// Anything registered with atexit() now runs before the destructors of everything constructed before now, which covers the static data.
+	if (!exit_handler)
+	{
+		std::atexit(wait_for_pending);
+		exit_handler = true;
+	}
+	shared_ptr<Dungeon> level = std::make_shared<Dungeon>(world::unique_id(), 100, 100);
+	pending.insert(std::make_pair(depth, std::async(std::launch::async, [level, seed]()
+	{
+		level->generate(seed);
+		return level;
+	})));
+}
+
+// Forgets about all dungeon levels, ready for a new game.
+void reset()
+{
+	STACK_TRACE();
+	current_depth = 0;
+	level_ids.clear();
+	pending.clear();	// Any levels still being generated are waited for, then thrown away.
+	resident.clear();
+}
+
+// Saves every dungeon level in memory to disk, along with the level index.
+void save()
+{
+	STACK_TRACE();
+	for (auto level : resident)
+		level->save();
+	save_index();
+}
+
+// Saves the level index to disk.
+void save_index()
+{
+	STACK_TRACE();
+	try
+	{
+		world::save_db()->exec("DELETE FROM levels");
+		SQLite::Statement statement(*world::save_db(), "INSERT INTO levels (depth, dungeon_id, current) VALUES (?, ?, ?)");
+		for (auto level : level_ids)
+		{
+			statement.bind(1, level.first);
+			statement.bind(2, static_cast<signed long long>(level.second));
+			statement.bind(3, level.first == current_depth);
+			statement.exec();
+			statement.reset();
+		}
+	}
+	catch (std::exception &e)
+	{
+		guru::halt(e.what());
+	}
+}
+
+// Waits for any dungeon levels being generated in the background to finish.
+// This runs after the stack trace has been torn down at exit, so it can't use STACK_TRACE().
+void wait_for_pending()
+{
+	for (auto &level : pending)
+		level.second.wait();
+}
+
+}	// namespace levels
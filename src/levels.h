@@ -0,0 +1,22 @@
+// levels.h -- The level manager, which keeps the most recently visited dungeon levels in memory, and writes the rest out to the save file.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#pragma once
+#include "duskfall.h"
+
+class Dungeon;	// defined in dungeon.h
+
+#define LEVEL_CACHE_SIZE	4	// The number of dungeon levels which are kept in memory at once. All but the current one are frozen (see Dungeon::freeze()).
+
+
+namespace levels
+{
+
+unsigned short		current();	// The depth of the current dungeon level.
+shared_ptr<Dungeon>	enter(unsigned short depth);	// Makes the dungeon level at the specified depth current, loading or generating it as needed.
+void				load();		// Loads the level index from disk.
+void				pregenerate(unsigned short depth);	// Starts generating the dungeon level at the specified depth in the background, if it doesn't already exist.
+void				reset();	// Forgets about all dungeon levels, ready for a new game.
+void				save();		// Saves every dungeon level in memory to disk, along with the level index.
+
+}	// namespace levels
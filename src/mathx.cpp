@@ -10,12 +10,15 @@
 #include <cmath>
 #include <random>
 
+#define GRID_DIST_TABLE_SIZE	16384	// The number of squared distances covered by the grid distance lookup table (up to 128 tiles apart).
+
 
 namespace mathx
 {
 
 std::chrono::time_point<std::chrono::system_clock> dev_timer;	// Timer used for testing.
-pcg32			*pcg = nullptr;	// PCG random number generator.
+thread_local std::unique_ptr<pcg32>	pcg;	// PCG random number generator. Each thread has its own, so background level generation doesn't disturb the main thread's sequence.
+vector<unsigned char>	grid_dist_table;	// The whole-number grid distance for each squared distance, built the first time it's needed.
 unsigned int	prand_seed = 0;		// Pseudorandom number seed.
 
 // Checks to see if a flag is set.
@@ -46,11 +49,27 @@ float grid_dist(long long x1, long long y1, long long x2, long long y2)
 	return round_to_two(dist);
 }
 
+// As grid_dist(), but rounded down to a whole number of tiles, using a lookup table for nearby points.
+unsigned int grid_dist_int(int x1, int y1, int x2, int y2)
+{
+	const unsigned int dist_x = abs(x2 - x1), dist_y = abs(y2 - y1);
+	if (dist_x >= 128 || dist_y >= 128) return grid_dist(x1, y1, x2, y2);
+	const unsigned int dist_sq = dist_x * dist_x + dist_y * dist_y;
+	if (dist_sq >= GRID_DIST_TABLE_SIZE) return grid_dist(x1, y1, x2, y2);
+	if (!grid_dist_table.size())
+	{
+		grid_dist_table.resize(GRID_DIST_TABLE_SIZE);
+		for (unsigned int i = 0; i < GRID_DIST_TABLE_SIZE; i++)
+			grid_dist_table.at(i) = static_cast<unsigned int>(round_to_two(sqrt(i)));
+	}
+	return grid_dist_table[dist_sq];
+}
+
 // Sets up PCG pseudorandom number generator.
 void init()
 {
 	STACK_TRACE();
-	pcg = new pcg32(pcg_extras::seed_seq_from<std::random_device>{});
+	pcg.reset(new pcg32(pcg_extras::seed_seq_from<std::random_device>{}));
 	guru::log("Pseudorandom number generator initialized.");
 }
 
@@ -146,4 +165,11 @@ float round_to_two(float num)
 	return floorf(num * 100 + 0.5) / 100;
 }
 
+// Gives the calling thread its own pseudorandom number generator, with a specified seed.
+void seed_thread(unsigned long long seed)
+{
+	STACK_TRACE();
+	pcg.reset(new pcg32(seed));
+}
+
 }	// namespace mathx
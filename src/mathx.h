@@ -14,6 +14,7 @@ bool			check_flag(unsigned int flags, unsigned int flag_to_check);	// Checks to
 void			dev_timer_start();	// Starts a timer for debugging/testing purposes.
 float			dev_timer_stop();	// Stops the timer and reports the result.
 float			grid_dist(long long x1, long long y1, long long x2, long long y2);	// Determines the difference between two points on a grid.
+unsigned int	grid_dist_int(int x1, int y1, int x2, int y2);	// As grid_dist(), but rounded down to a whole number of tiles, using a lookup table for nearby points.
 void			init();						// Sets up PCG pseudorandom number generator.
 bool			is_odd(unsigned int num);	// Checks if a number is odd.
 double			perlin(double x, double y, double zoom, double p, int octaves);	// Simple perlin noise generation.
@@ -24,5 +25,6 @@ unsigned char	perlin_rgb(double x, double y, double zoom, double p, int octaves)
 unsigned int	prand(unsigned int lim);	// Simpler, easily-seedable pseudorandom number generator.
 unsigned int	rnd(unsigned int max);		// Returns a random number between 1 and max.
 float			round_to_two(float num);	// Rounds a float to two decimal places.
+void			seed_thread(unsigned long long seed);	// Gives the calling thread its own pseudorandom number generator, with a specified seed.
 
 }	// namespace mathx
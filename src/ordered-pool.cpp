@@ -0,0 +1,41 @@
+// ordered-pool.cpp -- The OrderedPool class, a list of indices which can be removed by their position among the indices remaining, without shuffling the rest of the list along.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#include "guru.h"
+#include "ordered-pool.h"
+
+
+// Creates a pool containing every index from 0 to new_size - 1.
+OrderedPool::OrderedPool(unsigned int new_size) : remaining(new_size), top_bit(1), tree(new_size + 1, 0)
+{
+	STACK_TRACE();
+	// Every index starts in the pool, so each node of the tree just counts the indices it covers.
+	for (unsigned int i = 1; i <= new_size; i++)
+		tree[i] = i & -i;
+	while (top_bit * 2 <= new_size) top_bit *= 2;
+}
+
+// Removes the index at the specified position among those remaining, and returns it. This gives exactly the same result as erasing that position from a vector of the remaining indices, but
+// takes logarithmic time rather than linear.
+unsigned int OrderedPool::take(unsigned int pos)
+{
+	if (pos >= remaining) guru::halt("Invalid position in ordered pool!");
+
+	// Walk down the tree to find the index with exactly pos indices remaining before it.
+	unsigned int index = 0;
+	for (unsigned int bit = top_bit; bit; bit >>= 1)
+	{
+		const unsigned int next = index + bit;
+		if (next < tree.size() && tree[next] <= pos)
+		{
+			index = next;
+			pos -= tree[next];
+		}
+	}
+
+	// The index found is zero-based; the tree is one-based, so index + 1 is its node.
+	for (unsigned int i = index + 1; i < tree.size(); i += i & -i)
+		tree[i]--;
+	remaining--;
+	return index;
+}
@@ -0,0 +1,19 @@
+// ordered-pool.h -- The OrderedPool class, a list of indices which can be removed by their position among the indices remaining, without shuffling the rest of the list along.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#pragma once
+#include "duskfall.h"
+
+
+class OrderedPool
+{
+public:
+			OrderedPool(unsigned int new_size);	// Creates a pool containing every index from 0 to new_size - 1.
+	unsigned int	size() const { return remaining; }	// The number of indices left in the pool.
+	unsigned int	take(unsigned int pos);	// Removes the index at the specified position among those remaining, and returns it.
+
+private:
+	unsigned int	remaining;	// The number of indices left in the pool.
+	unsigned int	top_bit;	// The highest power of two no greater than the pool's original size, used to search the tree.
+	vector<unsigned int>	tree;	// A binary indexed tree counting the indices left in the pool. Entry 0 is unused.
+};
@@ -0,0 +1,35 @@
+// ray-table.cpp -- The RayTable class, a precomputed set of line-of-sight rays, so that large numbers of line-of-sight checks can be made without tracing each line from scratch.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#include "guru.h"
+#include "ray-table.h"
+
+
+// Traces every ray up to the specified range.
+void RayTable::build(unsigned short new_range)
+{
+	STACK_TRACE();
+	ray_range = new_range;
+	const unsigned int side = ray_range * 2 + 1;
+	ray_start.clear();
+	ray_start.reserve(side * side + 1);
+	steps.clear();
+	for (int dy = -ray_range; dy <= ray_range; dy++)
+	{
+		for (int dx = -ray_range; dx <= ray_range; dx++)
+		{
+			ray_start.push_back(steps.size());
+			walk(dx, dy, [this](int x, int y) { steps.push_back({ static_cast<short>(x), static_cast<short>(y) }); return true; });
+		}
+	}
+	ray_start.push_back(steps.size());
+	steps.shrink_to_fit();
+}
+
+// Returns the steps along the ray to a specified offset, which must be within range.
+const RayStep* RayTable::ray(int dx, int dy, unsigned int &length) const
+{
+	const unsigned int index = (dx + ray_range) + (dy + ray_range) * (ray_range * 2 + 1);
+	length = ray_start[index + 1] - ray_start[index];
+	return steps.data() + ray_start[index];
+}
@@ -0,0 +1,69 @@
+// ray-table.h -- The RayTable class, a precomputed set of line-of-sight rays, so that large numbers of line-of-sight checks can be made without tracing each line from scratch.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#pragma once
+#include "duskfall.h"
+
+
+// A single step along a ray, relative to the start of the ray.
+class RayStep
+{
+public:
+	short	x, y;	// The offset of this step from the start of the ray.
+};
+
+class RayTable
+{
+public:
+			RayTable() : ray_range(0) { }
+	void	build(unsigned short new_range);	// Traces every ray up to the specified range.
+	const RayStep*	ray(int dx, int dy, unsigned int &length) const;	// Returns the steps along the ray to a specified offset, which must be within range.
+	unsigned short	range() const { return ray_range; }	// The maximum range of the rays in this table, or 0 if it hasn't been built yet.
+	template<class F> static bool	walk(int dx, int dy, F visit);	// Walks along a single ray to a specified offset, calling visit(x, y) for each step until it returns false.
+
+private:
+	unsigned short			ray_range;	// The maximum range of the rays in this table.
+	vector<unsigned int>	ray_start;	// Where each ray starts within the steps vector, indexed by offset; the extra entry at the end marks the end of the last ray.
+	vector<RayStep>			steps;		// The steps along every ray, stored end to end.
+};
+
+// Walks along a single ray to a specified offset, calling visit(x, y) for each step until it returns false. This follows exactly the same line as Dungeon::los_check(), including the final step onto
+// the target, but not the starting tile. Returns true if the end of the ray was reached.
+template<class F> bool RayTable::walk(int dx, int dy, F visit)
+{
+	int x = 0, y = 0;
+	const int ix = (dx > 0) - (dx < 0), iy = (dy > 0) - (dy < 0);
+	const int delta_x = (dx < 0 ? -dx : dx) << 1, delta_y = (dy < 0 ? -dy : dy) << 1;
+
+	if (delta_x >= delta_y)
+	{
+		int error = delta_y - (delta_x >> 1);
+		while (x != dx)
+		{
+			if ((error > 0) || (!error && (ix > 0)))
+			{
+				error -= delta_x;
+				y += iy;
+			}
+			error += delta_y;
+			x += ix;
+			if (!visit(x, y)) return false;
+		}
+	}
+	else
+	{
+		int error = delta_x - (delta_y >> 1);
+		while (y != dy)
+		{
+			if ((error > 0) || (!error && (iy > 0)))
+			{
+				error -= delta_y;
+				x += ix;
+			}
+			error += delta_x;
+			y += iy;
+			if (!visit(x, y)) return false;
+		}
+	}
+	return true;
+}
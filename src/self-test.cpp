@@ -0,0 +1,137 @@
+// self-test.cpp -- Self-tests for game logic, which can be run from the command line to check things that are hard to catch by just playing.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#include "actor.h"
+#include "controls.h"
+#include "defender.h"
+#include "dungeon.h"
+#include "filex.h"
+#include "guru.h"
+#include "hero.h"
+#include "self-test.h"
+#include "static-data.h"
+#include "strx.h"
+#include "world.h"
+
+#include <iostream>
+
+
+namespace selftest
+{
+
+bool	fail(string reason);	// Reports a failed self-test, and returns false.
+void	start_game();	// Starts a new game in the self-test save slot.
+
+
+// Reports a failed self-test, and returns false.
+bool fail(string reason)
+{
+	STACK_TRACE();
+	std::cout << "FAILED: " << reason << std::endl;
+	guru::log("Self-test failed: " + reason, GURU_ERROR);
+	return false;
+}
+
+// The hero kills a monster in melee, which should take it off its tile without anything still using it afterwards.
+bool kill_monster()
+{
+	STACK_TRACE();
+	start_game();
+
+	// Find somewhere next to the hero for the monster to stand.
+	const shared_ptr<Dungeon> dungeon = world::dungeon();
+	const unsigned short hero_x = world::hero()->x, hero_y = world::hero()->y;
+	const short directions[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+	short dx = 0, dy = 0;
+	for (auto dir : directions)
+	{
+		if (dungeon->blocks_movement(hero_x + dir[0], hero_y + dir[1])) continue;
+		dx = dir[0];
+		dy = dir[1];
+		break;
+	}
+	if (!dx && !dy) return fail("kill_monster: no free tile next to the hero.");
+
+	// Only the tile holds on to the monster, just as it would for one spawned by the dungeon generator. It's given 1 HP, so a single hit kills it.
+	const MobID orc_id = data::mob_id("ORC");
+	const unsigned short prototype_hp = data::mob(orc_id).defender->hp;
+	std::weak_ptr<Actor> monster_watch;
+	{
+		shared_ptr<Actor> monster = data::get_mob(orc_id);
+		monster->own_defender()->hp = 1;
+		dungeon->tile(hero_x + dx, hero_y + dy).add_actor(monster);
+		monster_watch = monster;
+	}
+
+	world::hero()->controls()->travel(dx, dy);
+	if (!monster_watch.expired()) return fail("kill_monster: the monster is still alive after being killed.");
+	if (dungeon->tile(hero_x + dx, hero_y + dy).mobs_here().size()) return fail("kill_monster: the monster's tile still has a monster in it.");
+	if (dungeon->blocks_movement(hero_x + dx, hero_y + dy)) return fail("kill_monster: the monster's tile is still blocked.");
+	if (world::hero()->x != hero_x || world::hero()->y != hero_y) return fail("kill_monster: the hero moved instead of attacking.");
+	if (data::mob(orc_id).defender->hp != prototype_hp) return fail("kill_monster: damage to the monster changed its prototype.");
+	return true;
+}
+
+// A static light source's light map should cover its full radius, whether or not the hero's light is being culled to the screen when it's worked out.
+bool light_culling()
+{
+	STACK_TRACE();
+	start_game();
+	const shared_ptr<Dungeon> dungeon = world::dungeon();
+	const unsigned short hero_x = world::hero()->x, hero_y = world::hero()->y;
+	const bool culling_was = Dungeon::light_culling;
+	const unsigned short margin_was = Dungeon::light_cull_margin;
+
+	// With the hero in the top-left corner of the screen and no margin, culling cuts off everything to the left of the light, which always includes the tile right next to it.
+	world::hero()->camera_off_x = -hero_x;
+	world::hero()->camera_off_y = -hero_y;
+	Dungeon::light_cull_margin = 0;
+	Dungeon::light_culling = true;
+	dungeon->recalc_lighting();
+	unsigned int light_id = dungeon->add_light(hero_x, hero_y, 10);
+	dungeon->recalc_lighting();
+	const LightSource culled = dungeon->get_light(light_id);
+	dungeon->remove_light(light_id);
+
+	Dungeon::light_culling = false;
+	dungeon->recalc_lighting();
+	light_id = dungeon->add_light(hero_x, hero_y, 10);
+	dungeon->recalc_lighting();
+	const LightSource unculled = dungeon->get_light(light_id);
+	dungeon->remove_light(light_id);
+	Dungeon::light_culling = culling_was;
+	Dungeon::light_cull_margin = margin_was;
+	world::hero()->recenter_camera();
+	dungeon->recalc_lighting();
+
+	if (culled.light_map != unculled.light_map) return fail("light_culling: the light map changed when culling was turned on.");
+	if (culled.walls != unculled.walls) return fail("light_culling: the lit walls changed when culling was turned on.");
+	return true;
+}
+
+// Runs all the self-tests, and reports the results. Returns false if any of them failed.
+bool run()
+{
+	STACK_TRACE();
+	unsigned int failed = 0;
+	if (!kill_monster()) failed++;
+	if (!light_culling()) failed++;
+	const string result = (failed ? strx::uitos(failed) + " self-test(s) failed." : "All self-tests passed.");
+	std::cout << result << std::endl;
+	guru::log(result, failed ? GURU_ERROR : GURU_INFO);
+	return !failed;
+}
+
+// Starts a new game in the self-test save slot.
+void start_game()
+{
+	STACK_TRACE();
+	const string save_dir = "userdata/save/" + strx::itos(SELF_TEST_SLOT);
+	filex::remove_directory(save_dir);
+	filex::make_dir("userdata/save");
+	filex::make_dir(save_dir);
+	world::new_world(SELF_TEST_SLOT, true);
+	world::new_game();
+}
+
+}	// namespace selftest
@@ -0,0 +1,17 @@
+// self-test.h -- Self-tests for game logic, which can be run from the command line to check things that are hard to catch by just playing.
+// Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
+
+#pragma once
+#include "duskfall.h"
+
+#define SELF_TEST_SLOT	999	// The save slot used by the self-tests, well beyond any slot shown on the title screen.
+
+
+namespace selftest
+{
+
+bool	kill_monster();	// The hero kills a monster in melee, which should take it off its tile without anything still using it afterwards.
+bool	light_culling();	// A static light source's light map should cover its full radius, whether or not the hero's light is being culled to the screen when it's worked out.
+bool	run();			// Runs all the self-tests, and reports the results. Returns false if any of them failed.
+
+}	// namespace selftest
@@ -4,8 +4,8 @@
 #include "duskfall.h"
 
 
-// Stack trace system.
-std::stack<const char*>	StackTrace::funcs;
+// Stack trace system. Each thread keeps its own stack, so levels generated in the background don't get tangled up with the main thread.
+thread_local std::stack<const char*>	StackTrace::funcs;
 
 StackTrace::StackTrace(const char *func)
 {
@@ -10,6 +10,6 @@ class	StackTrace
 public:
 	StackTrace(const char *func);
 	~StackTrace();
-	static std::stack<const char*>	funcs;
+	static thread_local std::stack<const char*>	funcs;
 };
 #define STACK_TRACE()	StackTrace local_stack(__PRETTY_FUNCTION__)
@@ -2,6 +2,7 @@
 // Copyright (c) 2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
 
 #include "actor.h"
+#include "atom.h"
 #include "attacker.h"
 #include "defender.h"
 #include "dungeon.h"
@@ -24,67 +25,85 @@ enum class ActorType : unsigned int { MONSTER, ITEM, TILE_FEATURE };
 namespace data
 {
 
-std::unordered_map<string, shared_ptr<Actor>>	static_item_data;	// The data containing templates for items from items.json
-std::unordered_map<string, shared_ptr<Actor>>	static_mob_data;	// The data containing templates for monsters from mobs.json
-std::unordered_map<string, shared_ptr<Tile>>	static_tile_data;	// The data about dungeon tiles from tiles.json
-std::unordered_map<string, shared_ptr<Actor>>	static_tile_feature_data;	// The data containing templates for tile features from tile features.json
+std::unordered_map<string, unsigned short>	item_ids;	// The numeric IDs of the items in items.json, keyed by their string IDs.
+std::unordered_map<string, unsigned short>	mob_ids;	// The numeric IDs of the monsters in mobs.json, keyed by their string IDs.
+vector<shared_ptr<Actor>>	static_item_data;	// The data containing templates for items from items.json, indexed by ItemID.
+vector<shared_ptr<Actor>>	static_mob_data;	// The data containing templates for monsters from mobs.json, indexed by MobID.
+vector<TilePrototype>		static_tile_data;	// The data about dungeon tiles from tiles.json, indexed by TileID.
+vector<shared_ptr<Actor>>	static_tile_feature_data;	// The data containing templates for tile features from tile features.json, indexed by TileFeatureID.
+std::unordered_map<string, unsigned short>	tile_feature_ids;	// The numeric IDs of the tile features in tile features.json, keyed by their string IDs.
+std::unordered_map<string, unsigned short>	tile_ids;	// The numeric IDs of the tiles in tiles.json, keyed by their string IDs.
 
+unsigned short	find_id(const std::unordered_map<string, unsigned short> &ids, string id, string type);	// Internal code used by item_id(), mob_id(), tile_feature_id() and tile_id().
+
+
+// Internal code used by item_id(), mob_id(), tile_feature_id() and tile_id().
+unsigned short find_id(const std::unordered_map<string, unsigned short> &ids, string id, string type)
+{
+	STACK_TRACE();
+	auto found = ids.find(id);
+	if (found == ids.end()) guru::halt("Could not find " + type + " ID " + id + "!");
+	return found->second;
+}
 
 // Internal code used by get_item(), get_mob() and get_tile_feature().
-shared_ptr<Actor> get_actor(std::unordered_map<string, shared_ptr<Actor>> &map, string id, string type)
+// The new Actor uses its prototype's Attacker and Defender rather than copies of its own, until it needs to change them (see Actor::own_defender()), so most Actors cost just the one allocation.
+shared_ptr<Actor> get_actor(const Actor &proto)
 {
 	STACK_TRACE();
-	auto found = map.find(id);
-	if (found == map.end()) guru::halt("Could not find " + type + " ID " + id + "!");
-	shared_ptr<Actor> result = std::make_shared<Actor>(*found->second);
+	shared_ptr<Actor> result = std::make_shared<Actor>(proto);
 	result->id = world::unique_id();
-	if (result->attacker)
-	{
-		result->attacker = std::make_shared<Attacker>(*result->attacker);
-		result->attacker->id = world::unique_id();
-	}
-	if (result->defender)
-	{
-		result->defender = std::make_shared<Defender>(*result->defender);
-		result->defender->id = world::unique_id();
-	}
+	if (result->attacker) result->shared |= ACTOR_SHARED_ATTACKER;
+	if (result->defender) result->shared |= ACTOR_SHARED_DEFENDER;
 	if (result->inventory)
 	{
 		result->inventory = std::make_shared<Inventory>(*result->inventory);
 		result->inventory->id = world::unique_id();
 	}
-	if (result->ai_type.size()) result->add_ai(result->ai_type, world::unique_id());
+	if (result->ai_type != ATOM_NONE) result->add_ai(result->ai_type, world::unique_id());
 	return result;
 }
 
 // Retrieves a copy of the specified item.
+shared_ptr<Actor> get_item(ItemID item_id)
+{
+	STACK_TRACE();
+	return get_actor(item(item_id));
+}
+
+// As above, but looks the item up by its string ID.
 shared_ptr<Actor> get_item(string item_id)
 {
 	STACK_TRACE();
-	return get_actor(static_item_data, item_id, "item");
+	return get_item(data::item_id(item_id));
 }
 
 // Retrieves a copy of a specified mob.
-shared_ptr<Actor> get_mob(string mob_id)
+shared_ptr<Actor> get_mob(MobID mob_id)
 {
 	STACK_TRACE();
-	return get_actor(static_mob_data, mob_id, "mob");
+	return get_actor(mob(mob_id));
 }
 
-// Retrieves a copy of a specified Tile
-Tile get_tile(string tile_id)
+// As above, but looks the mob up by its string ID.
+shared_ptr<Actor> get_mob(string mob_id)
 {
 	STACK_TRACE();
-	auto found = static_tile_data.find(tile_id);
-	if (found == static_tile_data.end()) guru::halt("Could not retrieve tile ID " + tile_id + "!");
-	return *found->second;
+	return get_mob(data::mob_id(mob_id));
 }
 
 // Retrieves a copy of a specified tile feature.
+shared_ptr<Actor> get_tile_feature(TileFeatureID feature_id)
+{
+	STACK_TRACE();
+	return get_actor(tile_feature(feature_id));
+}
+
+// As above, but looks the tile feature up by its string ID.
 shared_ptr<Actor> get_tile_feature(string feature_id)
 {
 	STACK_TRACE();
-	return get_actor(static_tile_feature_data, feature_id, "tile feature");
+	return get_tile_feature(tile_feature_id(feature_id));
 }
 
 // Loads the static data from JSON files.
@@ -93,13 +112,13 @@ void init()
 	STACK_TRACE();
 	guru::log("Attempting to load static data from JSON files...", GURU_INFO);
 	init_tiles_json();
-	init_actors_json("items", ActorType::ITEM, &static_item_data);
-	init_actors_json("mobs", ActorType::MONSTER, &static_mob_data);
-	init_actors_json("tile features", ActorType::TILE_FEATURE, &static_tile_feature_data);
+	init_actors_json("items", ActorType::ITEM, &static_item_data, &item_ids);
+	init_actors_json("mobs", ActorType::MONSTER, &static_mob_data, &mob_ids);
+	init_actors_json("tile features", ActorType::TILE_FEATURE, &static_tile_feature_data, &tile_feature_ids);
 }
 
-// Loads an Actor's data from JSON.
-void init_actors_json(string filename, ActorType type, std::unordered_map<string, shared_ptr<Actor>> *the_map)
+// Loads an Actor's data from JSON. The member names come back from JsonCpp in sorted order, so each Actor's numeric ID is its position in that list.
+void init_actors_json(string filename, ActorType type, vector<shared_ptr<Actor>> *the_vec, std::unordered_map<string, unsigned short> *the_ids)
 {
 	STACK_TRACE();
 	const std::unordered_map<string, unsigned int> actor_flag_map = { { "BLOCKER", ACTOR_FLAG_BLOCKER }, { "BLOCKS_LOS", ACTOR_FLAG_BLOCKS_LOS }, { "MONSTER", ACTOR_FLAG_MONSTER }, { "ITEM", ACTOR_FLAG_ITEM },
@@ -107,6 +126,9 @@ void init_actors_json(string filename, ActorType type, std::unordered_map<string
 
 	Json::Value json = filex::load_json("json/" + filename);
 	const Json::Value::Members jmem = json.getMemberNames();
+	if (jmem.size() >= STATIC_ID_NONE) guru::halt("Too many entries in " + filename + ".json!");
+	the_vec->clear();
+	the_ids->clear();
 	for (unsigned int i = 0; i < jmem.size(); i++)
 	{
 		const string actor_id = jmem.at(i);
@@ -116,11 +138,11 @@ void init_actors_json(string filename, ActorType type, std::unordered_map<string
 
 		const string actor_name = jval.get("name", "").asString();
 		if (!actor_name.size()) guru::nonfatal("No actor name specified for " + actor_id, GURU_ERROR);
-		else actor->name = actor_name;
+		else actor->name = atom::intern(actor_name);
 
 		const string actor_tile = jval.get("tile", "").asString();
 		if (!actor_tile.size()) guru::nonfatal("No tile specified for " + actor_id, GURU_ERROR);
-		else actor->sprite = actor_tile;
+		else actor->sprite = atom::intern(actor_tile);
 
 		const string actor_flags_unparsed = jval.get("flags", "").asString();
 		actor->flags = 0;
@@ -143,7 +165,7 @@ void init_actors_json(string filename, ActorType type, std::unordered_map<string
 		}
 
 		const string actor_ai = jval.get("ai", "").asString();
-		if (actor_ai.size()) actor->ai_type = actor_ai;
+		if (actor_ai.size()) actor->ai_type = atom::intern(actor_ai);
 
 		auto attacker_pos = std::find(jmem_actor.begin(), jmem_actor.end(), "attacker");
 		if (attacker_pos != jmem_actor.end())
@@ -170,7 +192,8 @@ void init_actors_json(string filename, ActorType type, std::unordered_map<string
 		}
 		else if (type == ActorType::ITEM && !not_item) actor->flags |= ACTOR_FLAG_ITEM;	// Items are marked as items unless specified otherwise.
 
-		the_map->insert(std::pair<string, shared_ptr<Actor>>(actor_id, actor));
+		the_ids->insert(std::pair<string, unsigned short>(actor_id, the_vec->size()));
+		the_vec->push_back(actor);
 	}
 }
 
@@ -184,14 +207,18 @@ void init_tiles_json()
 
 	Json::Value json = filex::load_json("json/tiles");
 	const Json::Value::Members jmem = json.getMemberNames();
+	if (jmem.size() >= STATIC_ID_NONE) guru::halt("Too many entries in tiles.json!");
+	static_tile_data.clear();
+	tile_ids.clear();
 	for (unsigned int i = 0; i < jmem.size(); i++)
 	{
 		const string tile_id = jmem.at(i);
 		const Json::Value jval = json[tile_id];
-		auto new_tile = std::make_shared<Tile>();
+		TilePrototype new_tile;
+		new_tile.id = static_tile_data.size();
 
 		const string tile_flags_unparsed = jval.get("flags", "").asString();
-		new_tile->flags = 0;
+		new_tile.flags = 0;
 		if (tile_flags_unparsed.size())
 		{
 			const vector<string> tile_flags_vec = strx::string_explode(tile_flags_unparsed, " ");
@@ -199,20 +226,77 @@ void init_tiles_json()
 			{
 				auto found = tile_flag_map.find(strx::str_toupper(flag));
 				if (found == tile_flag_map.end()) guru::nonfatal("Unknown tile flag in tiles.json for " + tile_id + ": " + flag, GURU_ERROR);
-				else new_tile->flags |= found->second;
+				else new_tile.flags |= found->second;
 			}
 		}
 
 		const string tile_name = jval.get("name", "").asString();
 		if (!tile_name.size()) guru::nonfatal("No name specified in tiles.json for " + tile_id, GURU_ERROR);
-		else new_tile->name = tile_name;
+		else new_tile.name = tile_name;
 
 		const string tile_sprite = jval.get("tile", "").asString();
 		if (!tile_sprite.size()) guru::nonfatal("No tile sprite specified in tiles.json for " + tile_id, GURU_ERROR);
-		else new_tile->set_sprite(tile_sprite);
+		else new_tile.set_sprite(tile_sprite);
 
-		static_tile_data.insert(std::pair<string, shared_ptr<Tile>>(tile_id, new_tile));
+		tile_ids.insert(std::pair<string, unsigned short>(tile_id, new_tile.id));
+		static_tile_data.push_back(new_tile);
 	}
 }
 
+// Read-only access to the prototype for a specified item.
+const Actor& item(ItemID item_id)
+{
+	if (item_id >= static_item_data.size()) guru::halt("Invalid item ID: " + strx::uitos(item_id));
+	return *static_item_data[item_id];
+}
+
+// Looks up the numeric ID of an item.
+ItemID item_id(string item_id)
+{
+	STACK_TRACE();
+	return find_id(item_ids, item_id, "item");
+}
+
+// Read-only access to the prototype for a specified mob.
+const Actor& mob(MobID mob_id)
+{
+	if (mob_id >= static_mob_data.size()) guru::halt("Invalid mob ID: " + strx::uitos(mob_id));
+	return *static_mob_data[mob_id];
+}
+
+// Looks up the numeric ID of a mob.
+MobID mob_id(string mob_id)
+{
+	STACK_TRACE();
+	return find_id(mob_ids, mob_id, "mob");
+}
+
+// Read-only access to a specified TilePrototype.
+const TilePrototype& tile(TileID tile_id)
+{
+	if (tile_id >= static_tile_data.size()) guru::halt("Invalid tile ID: " + strx::uitos(tile_id));
+	return static_tile_data[tile_id];
+}
+
+// Read-only access to the prototype for a specified tile feature.
+const Actor& tile_feature(TileFeatureID feature_id)
+{
+	if (feature_id >= static_tile_feature_data.size()) guru::halt("Invalid tile feature ID: " + strx::uitos(feature_id));
+	return *static_tile_feature_data[feature_id];
+}
+
+// Looks up the numeric ID of a tile feature.
+TileFeatureID tile_feature_id(string feature_id)
+{
+	STACK_TRACE();
+	return find_id(tile_feature_ids, feature_id, "tile feature");
+}
+
+// Looks up the numeric ID of a TilePrototype.
+TileID tile_id(string tile_id)
+{
+	STACK_TRACE();
+	return find_id(tile_ids, tile_id, "tile");
+}
+
 }	// namespace data
@@ -6,24 +6,43 @@
 #include <unordered_map>
 
 class Actor;	// defined in actor.h
-class Tile;		// defined in dungeon.h
+class TilePrototype;	// defined in dungeon.h
 enum class ActorType : unsigned int;	// defined in static-data.cpp
 enum class Colour : unsigned char;		// defined in iocore.h
 namespace Json { class Value; }			// defined in json.cpp/json/json.h
 
+#define STATIC_ID_NONE	USHRT_MAX	// A prototype ID which doesn't refer to anything in the static data.
+
+// Numeric IDs for the prototypes in the JSON data files. These are assigned in alphabetical order of their string IDs when the data is loaded, so they stay the same as long as the data files do.
+// Code which uses the same prototype over and over should look its ID up once, rather than going through the string IDs every time.
+typedef unsigned short	ItemID;			// The ID of an item prototype from items.json
+typedef unsigned short	MobID;			// The ID of a mob prototype from mobs.json
+typedef unsigned short	TileFeatureID;	// The ID of a tile feature prototype from tile features.json
+typedef unsigned short	TileID;			// The ID of a TilePrototype from tiles.json
+
 
 namespace data
 {
 
-shared_ptr<Actor>	get_actor(std::unordered_map<string, shared_ptr<Actor>> &map, string id, string type);	// Internal code used by get_item(), get_mob() and get_tile_feature().
-shared_ptr<Actor>	get_item(string item_id);	// Retrieves a copy of the specified item.
-shared_ptr<Actor>	get_mob(string mob_id);		// Retrieves a copy of a specified mob.
-Tile				get_tile(string tile_id);	// Retrieves a copy of a specified Tile.
-shared_ptr<Actor>	get_tile_feature(string feature_id);	// Retrieves a copy of a specified tile feature.
+shared_ptr<Actor>	get_actor(const Actor &proto);	// Internal code used by get_item(), get_mob() and get_tile_feature().
+shared_ptr<Actor>	get_item(ItemID item_id);	// Retrieves a copy of the specified item.
+shared_ptr<Actor>	get_item(string item_id);	// As above, but looks the item up by its string ID.
+shared_ptr<Actor>	get_mob(MobID mob_id);		// Retrieves a copy of a specified mob.
+shared_ptr<Actor>	get_mob(string mob_id);		// As above, but looks the mob up by its string ID.
+shared_ptr<Actor>	get_tile_feature(TileFeatureID feature_id);	// Retrieves a copy of a specified tile feature.
+shared_ptr<Actor>	get_tile_feature(string feature_id);	// As above, but looks the tile feature up by its string ID.
 void				init();	// Loads the static data from JSON files.
-void				init_actors_json(string filename, ActorType type, std::unordered_map<string, shared_ptr<Actor>> *the_map);	// Loads an Actor's data from JSON.
+void				init_actors_json(string filename, ActorType type, vector<shared_ptr<Actor>> *the_vec, std::unordered_map<string, unsigned short> *the_ids);	// Loads an Actor's data from JSON.
 void				init_items_json();	// Load the data from items.json
 void				init_mobs_json();	// Load the data from mobs.json
 void				init_tiles_json();	// Load the data from tiles.json
+const Actor&		item(ItemID item_id);	// Read-only access to the prototype for a specified item.
+ItemID				item_id(string item_id);	// Looks up the numeric ID of an item.
+const Actor&		mob(MobID mob_id);		// Read-only access to the prototype for a specified mob.
+MobID				mob_id(string mob_id);	// Looks up the numeric ID of a mob.
+const TilePrototype&	tile(TileID tile_id);	// Read-only access to a specified TilePrototype.
+const Actor&		tile_feature(TileFeatureID feature_id);	// Read-only access to the prototype for a specified tile feature.
+TileFeatureID		tile_feature_id(string feature_id);	// Looks up the numeric ID of a tile feature.
+TileID				tile_id(string tile_id);	// Looks up the numeric ID of a TilePrototype.
 
 }	// namespace data
@@ -1,6 +1,7 @@
 // title.cpp -- Animated title screen, based on animated title screen code from Krasten, which in turn was based on animated title screen code from a long-forgotten project.
 // Copyright (c) 2016-2019 Raine "Gravecat" Simmons. Licensed under the GNU General Public License v3.
 
+#include "atom.h"
 #include "filex.h"
 #include "guru.h"
 #include "hero.h"
@@ -211,7 +212,7 @@ void choose_name()
 		{
 			done = true;
 			name = strx::trim_excess_spaces(name);
-			if (name.size()) world::hero()->name = name;
+			if (name.size()) world::hero()->name = atom::intern(name);
 			else
 			{
 				string new_name;
@@ -227,7 +228,7 @@ void choose_name()
 				iocore::alagard_print(new_name, pos, iocore::midrow() * 8, Colour::CGA_LCYAN);
 				iocore::flip();
 				iocore::sleep_for(1000);
-				world::hero()->name = new_name;
+				world::hero()->name = atom::intern(new_name);
 			}
 		}
 	} while(!done);
@@ -9,6 +9,7 @@
 #include "hero.h"
 #include "hud.h"
 #include "iocore.h"
+#include "levels.h"
 #include "message.h"
 #include "prefs.h"
 #include "strx.h"
@@ -19,13 +20,14 @@
 #include <chrono>
 #include <cmath>
 #include <set>
+#include <thread>
 
 
 namespace world
 {
 
 bool				db_ready = false;		// Is the database available for reading/writing?
-unsigned short		level = 0;				// The current dungeon level depth.
+const std::thread::id	main_thread = std::this_thread::get_id();	// The main thread, which is the only one allowed to touch the save file.
 bool				recalc_lighting = true;	// Recalculate the dynamic lighting at the start of the next turn.
 bool				recenter_camera = false;	// Does the dungeon camera need to be recentered?
 bool				redraw_full = true;		// Redraw the dungeon entirely at the start of the next turn.
@@ -34,8 +36,22 @@ unsigned short		save_slot = 0;			// The save file slot.
 shared_ptr<Dungeon>	the_dungeon = nullptr;	// The current dungeon level.
 shared_ptr<Hero>	the_hero = nullptr;		// The main Hero object.
 bool				time_passed = false;	// Has the player done something that causes time to pass?
+unsigned long long	unique_id_limit = 0;	// The end of the block of unique IDs reserved from the save file; IDs up to this one (inclusive) can be handed out without touching the save file.
+unsigned long long	unique_id_next = 0;		// The next unique ID to hand out from the reserved block.
 
 
+// Moves the Hero to a different dungeon level.
+void change_level(unsigned short depth)
+{
+	STACK_TRACE();
+	the_dungeon = levels::enter(depth);
+	the_dungeon->random_start_position(hero()->x, hero()->y);
+	levels::pregenerate(depth + 1);
+	queue_camera_recenter();
+	queue_recalc_lighting();
+	queue_redraw();
+}
+
 // Returns a pointer to the Dungeon object.
 shared_ptr<Dungeon>	dungeon()
 {
@@ -63,8 +79,9 @@ void load()
 {
 	STACK_TRACE();
 	db_ready = true;
-	the_dungeon = std::make_shared<Dungeon>(1005);
-	the_dungeon->load();
+	levels::load();
+	the_dungeon = levels::enter(levels::current());
+	levels::pregenerate(levels::current() + 1);
 	the_hero->load();
 	the_hero->recenter_camera();
 	message::load();
@@ -75,6 +92,8 @@ void new_world(unsigned short slot, bool new_save)
 {
 	STACK_TRACE();
 	save_slot = slot;
+	db_ready = false;
+	unique_id_limit = unique_id_next = 0;
 	try
 	{
 		save_db_ptr = new SQLite::Database("userdata/save/" + strx::itos(save_slot) + "/save.dat", SQLite::OPEN_READWRITE | (new_save ? SQLite::OPEN_CREATE : 0));
@@ -84,6 +103,8 @@ void new_world(unsigned short slot, bool new_save)
 		guru::halt(e.what());
 	}
 	the_hero = std::make_shared<Hero>(1);
+	the_dungeon = nullptr;
+	levels::reset();
 }
 
 // Queues up a recalculation of the game's dynamic lighting.
@@ -161,11 +182,10 @@ void main_loop()
 void new_game()
 {
 	STACK_TRACE();
-	level = 1;
 	hero()->x = hero()->y = 5;
-	the_dungeon = std::make_shared<Dungeon>(unique_id(), 100, 100);
-	the_dungeon->generate();
+	the_dungeon = levels::enter(1);
 	the_dungeon->random_start_position(hero()->x, hero()->y);
+	levels::pregenerate(2);
 	the_hero->recenter_camera();
 	message::msg("It is very dark. You are likely to be eaten by a grue.");
 	save(true);
@@ -203,8 +223,13 @@ void save(bool first_time)
 		SQLite::Transaction transaction(*save_db_ptr);
 		if (first_time)
 		{
-			save_db_ptr->exec("CREATE TABLE dungeon ( id INTEGER PRIMARY KEY UNIQUE NOT NULL, width INTEGER NOT NULL, height INTEGER NOT NULL ); "
-					"CREATE TABLE tiles ( dungeon_id INTEGER NOT NULL, x INTEGER NOT NULL, y INTEGER NOT NULL, name TEXT NOT NULL, sprite TEXT NOT NULL, flags INTEGER, PRIMARY KEY (dungeon_id, x, y) ); "
+			save_db_ptr->exec("CREATE TABLE dungeon ( id INTEGER PRIMARY KEY UNIQUE NOT NULL, width INTEGER NOT NULL, height INTEGER NOT NULL, fill INTEGER NOT NULL ); "
+					"CREATE TABLE palette ( dungeon_id INTEGER NOT NULL, id INTEGER NOT NULL, name TEXT NOT NULL, sprite TEXT NOT NULL, flags INTEGER NOT NULL, PRIMARY KEY (dungeon_id, id) ); "
+					"CREATE TABLE chunks ( dungeon_id INTEGER NOT NULL, cx INTEGER NOT NULL, cy INTEGER NOT NULL, proto BLOB NOT NULL, flags BLOB NOT NULL, room BLOB NOT NULL, PRIMARY KEY (dungeon_id, cx, cy) ); "
+					"CREATE TABLE rooms ( dungeon_id INTEGER NOT NULL, id INTEGER NOT NULL, x INTEGER NOT NULL, y INTEGER NOT NULL, w INTEGER NOT NULL, h INTEGER NOT NULL, corridor INTEGER NOT NULL, PRIMARY KEY (dungeon_id, id) ); "
+					"CREATE TABLE lights ( dungeon_id INTEGER NOT NULL, id INTEGER NOT NULL, x INTEGER NOT NULL, y INTEGER NOT NULL, radius INTEGER NOT NULL, PRIMARY KEY (dungeon_id, id) ); "
+					"CREATE TABLE doorways ( dungeon_id INTEGER NOT NULL, room INTEGER NOT NULL, x INTEGER NOT NULL, y INTEGER NOT NULL, target INTEGER NOT NULL ); "
+					"CREATE TABLE levels ( depth INTEGER PRIMARY KEY UNIQUE NOT NULL, dungeon_id INTEGER NOT NULL, current INTEGER NOT NULL ); "
 					"CREATE TABLE hero ( id INTEGER PRIMARY KEY AUTOINCREMENT, difficulty INTEGER NOT NULL, style INTEGER NOT NULL, played INTEGER NOT NULL ); "
 					"CREATE TABLE actors ( id INTEGER PRIMARY KEY UNIQUE NOT NULL, owner INTEGER NOT NULL, name TEXT, sprite TEXT NOT NULL, flags INTEGER NOT NULL, x INTEGER NOT NULL, y INTEGER NOT NULL, inventory INTEGER, "
 					"attacker INTEGER, defender INTEGER, ai INTEGER ); "
@@ -217,8 +242,17 @@ void save(bool first_time)
 
 		graveyard::purge();
 		hero()->save();
-		the_dungeon->save();
+		levels::save();
 		message::save();
+
+		// Record the last unique ID actually handed out, so the rest of the reserved block isn't wasted. The block is given up too, as the save file could now hand those IDs out again.
+		if (unique_id_limit)
+		{
+			SQLite::Statement id_statement(*save_db_ptr, "UPDATE sqlite_sequence SET seq = ? WHERE name = 'id_seq'");
+			id_statement.bind(1, static_cast<signed long long>(unique_id_next - 1));
+			id_statement.exec();
+			unique_id_limit = unique_id_next = 0;
+		}
 		transaction.commit();
 	}
 	catch (std::exception &e)
@@ -240,21 +274,32 @@ unsigned short slot()
 	return save_slot;
 }
 
-// Gets a unique item ID for a SQLite save file.
+// Gets a unique item ID for a SQLite save file. IDs are reserved from the save file in blocks of UNIQUE_ID_BLOCK, and handed out from memory until the block runs out.
 unsigned long long unique_id()
 {
 	STACK_TRACE();
+
+	// Dungeon levels generated in the background can't touch the save file, so anything created there is given an ID of 0 for now, and a real one when the level is handed over.
+	if (std::this_thread::get_id() != main_thread) return 0;
 	if (!db_ready)
 	{
 		// Use this simple system for the initial dungeon generation, then we can rely on SQLite for the rest.
 		static unsigned long long temporary_id = 1000;
 		return ++temporary_id;
 	}
+	if (unique_id_next && unique_id_next <= unique_id_limit) return unique_id_next++;
+
 	try
 	{
-		save_db_ptr->exec("DELETE FROM id_seq; INSERT INTO id_seq DEFAULT VALUES;");
-		SQLite::Statement query(*save_db_ptr, "SELECT last_insert_rowid();");
-		if (query.executeStep()) return query.getColumn("last_insert_rowid()").getInt64();
+		save_db_ptr->exec("UPDATE sqlite_sequence SET seq = seq + " + strx::itos(UNIQUE_ID_BLOCK) + " WHERE name = 'id_seq'");
+		SQLite::Statement query(*save_db_ptr, "SELECT seq FROM sqlite_sequence WHERE name = 'id_seq'");
+		if (query.executeStep())
+		{
+			unique_id_limit = query.getColumn("seq").getInt64();
+			unique_id_next = unique_id_limit - UNIQUE_ID_BLOCK + 1;
+			return unique_id_next++;
+		}
+		else guru::halt("Could not reserve unique IDs from the save file!");
 	}
 	catch (std::exception &e)
 	{
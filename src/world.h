@@ -9,10 +9,13 @@ class Actor;	// defined in actors.h
 class Dungeon;	// defined in dungeon.h
 class Hero;		// defined in hero.h
 
+#define UNIQUE_ID_BLOCK	4096	// The number of unique IDs reserved from the save file at a time.
+
 
 namespace world
 {
 
+void				change_level(unsigned short depth);	// Moves the Hero to a different dungeon level.
 shared_ptr<Dungeon>	dungeon();		// Returns a pointer to the Dungeon object.
 void				full_redraw();	// Redraws the entire screen.
 shared_ptr<Hero>	hero();			// Returns a pointer to the Hero object.